@@ -18,17 +18,128 @@
 class RfmBase {
 private:
     uint8_t pinSS;
+    static volatile bool spiBusy; // a chip is selected by the main loop, the bus shared by all modules can't be used from an ISR
+    uint32_t spiTransactions; // chipselect cycles since begin()
+    uint32_t spiBytes; // bytes transferred since begin(), including address bytes
+    uint8_t regCache[128]; // shadow copy of registers written or read through the driver
+    uint32_t regCached[4]; // bit n set: regCache[n] is valid
+    uint32_t regUncached[4]; // bit n set: register n holds commands or status only, it is never cached
+    uint8_t commandReg; // register with configuration and command bits, 0: none
+    uint8_t commandBits; // bits of commandReg which are not cached
+    bool regCacheVerify; // read cached registers from the chip anyway and count mismatches
+    uint32_t regCacheMismatches;
+    uint32_t spiBytesSaved; // bytes not transferred because of the register cache
+    bool edgeCapture; // continuous mode, dio2Isr() attached
+    static const uint8_t EDGERINGSIZE = 64; // power of 2
+    volatile uint32_t edgeRing[EDGERINGSIZE]; // micros() of an edge on DIO2, bit 0: level after the edge
+    volatile uint8_t edgeHead; // written by dio2Isr() only
+    volatile uint8_t edgeTail; // written by getEdge() only
+    volatile uint32_t edgeOverruns;
+    void select();
+    void deselect();
+    void cacheReg(const uint8_t reg, const uint8_t value);
+    bool isCached(const uint8_t reg) const { return (regCached[reg >> 5] & (1UL << (reg & 31))) != 0; }
+    bool isUncached(const uint8_t reg) const { return (regUncached[reg >> 5] & (1UL << (reg & 31))) != 0; }
+    static void dio2Isr(void *arg);
+public:
+    static const uint8_t NOPIN = 0xFF;
+
+    enum Modulation: uint8_t {
+        MODULATION_FSK = 0,
+        MODULATION_OOK = 1
+    };
+
+    enum FifoLevel {
+        FIFO_EMPTY,
+        FIFO_NOTEMPTY,
+        FIFO_THRESH,
+        FIFO_FULL
+    };
+
+    /**
+     * @brief LoRa modem settings, see Rfm9x::setLora()
+     */
+    struct LoraConfig {
+        uint8_t spreadingFactor; // 6..12, RFM97: 6..9
+        uint32_t bandwidth; // Hz, 7800..500000
+        uint8_t codingRate; // 5..8 for 4/5..4/8
+        uint8_t syncWord; // 0x12: private networks, 0x34: LoRaWAN
+        uint8_t implicitLen; // 0: explicit header, >0: payload length in implicit header mode
+        bool crc; // payload CRC required
+    };
 protected:
+    struct RfmConfig {
+        uint8_t reg;
+        uint8_t val;
+    };
+
+    uint8_t pinDio2 = NOPIN;
+    int16_t f_corr;
+    int32_t fei; // Hz, frequency error of the last received packet
+    Modulation modulation;
+    uint32_t modeTimeouts;
+    uint32_t fifoOverruns; // received bytes lost, the FIFO was full before getPayload(buf, maxlen)
+    uint32_t crcErrors; // LoRa packets dropped because of a payload CRC error
     uint8_t readReg(const uint8_t reg);
+    bool readRegIsr(const uint8_t reg, uint8_t &value);
+    uint8_t readRegCached(const uint8_t reg);
     uint16_t readReg16(const uint8_t reg);
+    void readRegBuf(const uint8_t reg, uint8_t *buf, const size_t size);
     void readFifo(uint8_t *buf, const size_t size);
     void writeReg(const uint8_t reg, const uint8_t value);
     void writeReg16(const uint8_t reg, const uint16_t value);
     void writeRegBuf(const uint8_t reg, const uint8_t *buf, const size_t size);
     void setReg(const uint8_t reg, const uint8_t set, const uint8_t clear);
+    void writeConfig(const RfmConfig cfg[], const uint8_t num);
+    void restoreRegs();
+    void setUncachedRegs(const uint8_t regs[], const uint8_t num, const uint8_t cmdReg = 0, const uint8_t cmdBits = 0);
+    void startEdgeCapture();
+    bool stopEdgeCapture();
+    static uint8_t rxBwValue(const uint32_t bw_hz, const bool ook);
 public:
     virtual void begin(const uint8_t pinSS);
-    virtual ~RfmBase() {}
+    virtual ~RfmBase();
+    uint32_t getSpiTransactions() const { return spiTransactions; }
+    uint32_t getSpiBytes() const { return spiBytes; }
+    uint32_t getSpiBytesSaved() const { return spiBytesSaved; }
+    uint32_t getRegCacheMismatches() const { return regCacheMismatches; }
+    void setRegCacheVerify(const bool verify) { regCacheVerify = verify; }
+    void resyncRegCache();
+    uint32_t getModeTimeouts() const { return modeTimeouts; }
+    uint32_t getEdgeOverruns() const { return edgeOverruns; }
+    uint32_t getFifoOverruns() const { return fifoOverruns; }
+    uint32_t getCrcErrors() const { return crcErrors; }
+    bool getEdge(uint32_t &time, bool &level);
+    void setFCorr(const int16_t fcorr) { f_corr = fcorr; }
+    int32_t getFei() const { return fei; }
+
+    // radio interface used by the applications
+    virtual void loop() = 0;
+    virtual void stop() = 0;
+    virtual void setModulation(const Modulation modulation) = 0;
+    virtual void setRxBandwidth(const uint32_t bw_hz) = 0;
+    virtual void setRssiThreshold(const uint8_t thresh) = 0;
+    virtual void setPreamble(const uint16_t len) = 0;
+    virtual void setFifoThreshold(const uint8_t thresh) = 0;
+    virtual void setSync(const uint8_t *sync, const int syncsize) = 0;
+    virtual void setTxPower(const int8_t power) = 0;
+    virtual void setFreq(const uint32_t freq_hz) = 0;
+    virtual void setBitrate(const uint16_t bit_s) = 0;
+    virtual bool setLora(const LoraConfig &cfg) { return false; } // false: no LoRa modem
+    virtual int8_t getSnr() { return 0; }
+
+    virtual void send(const uint8_t *data, const int size, const bool varSize = true) = 0;
+    virtual void txTest(const uint32_t freq_hz, const int16_t f_corr, const int8_t pwr, const uint16_t baud) = 0;
+
+    virtual bool isIdle() = 0;
+    virtual void startReceive(const int size = -1) = 0;
+    virtual bool startReceiveContinuous() = 0;
+    virtual bool payloadReady() = 0;
+    virtual uint8_t getPayload(uint8_t *buf) = 0;
+    virtual uint8_t getPayload(uint8_t *buf, const uint8_t maxlen) = 0;
+    virtual int8_t getRssi() = 0;
+    virtual FifoLevel getFifoLevel() = 0;
+    virtual void writeFifo(const uint8_t *buf, uint8_t len) = 0;
 };
 
 class Rfm69: public RfmBase {
@@ -40,13 +151,30 @@ private:
         MODE_TX = 3,
         MODE_RX = 4
     } mode;
+    enum Events: uint8_t {
+        EVENT_SYNC = 1<<0,
+        EVENT_PAYLOADREADY = 1<<1,
+        EVENT_PACKETSENT = 1<<2,
+        EVENT_RSSI = 1<<3 // syncRssi was read in the ISR
+    };
     void setMode(const Mode mode);
+    void recoverMode();
+    void mapDio0(const uint8_t mapping, const Events event);
+    void handleSync();
+    static void dio0Isr(void *arg);
+    void stopContinuous();
+    bool modeReady; // ModeReady seen since the last setMode()
+    uint32_t modeStart; // millis() of the last mode request
     bool highPower;
     int8_t txPwr;
     int rxSize;
-    int16_t f_corr;
     bool rssiflag;
     int8_t rssi;
+    uint8_t pinDio0 = NOPIN;
+    volatile Events dio0Event; // event signalled by a rising edge on DIO0 with the current mapping
+    volatile uint8_t events; // Events, set by dio0Isr()
+    volatile uint32_t syncTime; // micros() at sync address match
+    volatile uint8_t syncRssi; // RegRssiValue at sync address match
 public:
     enum Registers: uint8_t {
         RegFifo = 0x00,
@@ -74,6 +202,7 @@ public:
         RegFeiLsb = 0x22,
         RegRssiConfig = 0x23,
         RegRssiValue = 0x24,
+        RegDioMapping1 = 0x25,
         RegIrqFlags1 = 0x27,
         RegIrqFlags2 = 0x28,
         RegRssiThresh = 0x29,
@@ -123,39 +252,165 @@ public:
 
     };
 
-    enum FifoLevel {
-        FIFO_EMPTY,
-        FIFO_NOTEMPTY,
-        FIFO_THRESH,
-        FIFO_FULL
-    };
-
-    struct Rfm69Config {
-        Registers reg;
-        uint8_t val;
-    };
-
-    void begin(const uint8_t pinSS, const bool isHighPower);
+    ~Rfm69();
+    void begin(const uint8_t pinSS, const bool isHighPower, const uint8_t pinDio0 = NOPIN, const uint8_t pinDio2 = NOPIN);
     void loop();
     void stop();
+    void setModulation(const Modulation modulation);
+    void setRxBandwidth(const uint32_t bw_hz);
+    void setRssiThreshold(const uint8_t thresh);
+    void setPreamble(const uint16_t len);
+    void setFifoThreshold(const uint8_t thresh);
     void setSync(const uint8_t *sync, const int syncsize);
     void setAesKey(const uint8_t aeskey[16]);
     void enableAes(const bool enable);
     void setTxPower(const int8_t power);
     void setFreq(const uint32_t freq_hz);
     void setBitrate(const uint16_t bit_s);
-    void setFCorr(const int16_t fcorr);
-    void writeConfig(const Rfm69Config cfg[], const uint8_t num);
 
     void send(const uint8_t *data, const int size, const bool varSize = true);
     void txTest(const uint32_t freq_hz, const int16_t f_corr, const int8_t pwr, const uint16_t baud);
     
     bool isIdle();
+    bool isModeReady();
+    void startReceive(const int size = -1);
+    bool startReceiveContinuous();
+    bool payloadReady();
+    uint8_t getPayload(uint8_t *buf);
+    uint8_t getPayload(uint8_t *buf, const uint8_t maxlen);
+    int8_t getRssi();
+    uint32_t getSyncTime() const { return syncTime; }
+    FifoLevel getFifoLevel();
+    void writeFifo(const uint8_t *buf, uint8_t len);
+};
+
+/**
+ * @brief SX1276 based RFM95 / RFM96 / RFM97 / RFM98
+ * FSK / OOK in packet and continuous mode like Rfm69, LoRa reception with setLora().
+ * DIO0 signals PayloadReady / PacketSent, RxDone in LoRa mode. The SX127x can't route SyncAddress
+ * to DIO0, so the sync RSSI is still polled via SPI. DIO2 delivers the demodulated data in
+ * continuous mode.
+ */
+class Rfm9x: public RfmBase {
+private:
+    enum Mode: uint8_t {
+        MODE_SLEEP = 0,
+        MODE_STDBY = 1,
+        MODE_FSTX = 2,
+        MODE_TX = 3,
+        MODE_FSRX = 4,
+        MODE_RX = 5 // RXCONTINUOUS in LoRa mode
+    } mode;
+    void setMode(const Mode mode);
+    void setLoraMode(const bool lora);
+    void setUncachedFsk();
+    void writeFskConfig();
+    void recoverMode();
+    static void dio0Isr(void *arg);
+    void stopContinuous();
+    uint8_t getLoraPayload(uint8_t *buf, const uint8_t maxlen);
+    uint8_t opMode; // RegOpMode without the mode bits
+    bool modeReady; // ModeReady seen since the last setMode()
+    uint32_t modeStart; // millis() of the last mode request
+    int rxSize;
+    bool rssiflag;
+    int8_t rssi;
+    int8_t snr; // LoRa SNR of the last packet in dB
+    uint8_t pinDio0 = NOPIN;
+    volatile bool dio0Flag; // PayloadReady / PacketSent / RxDone, set by dio0Isr()
+public:
+    enum Registers: uint8_t {
+        RegFifo = 0x00,
+        RegOpMode = 0x01,
+        RegBitrateMsb = 0x02,
+        RegBitrateLsb = 0x03,
+        RegFdevMsb = 0x04,
+        RegFdevLsb = 0x05,
+        RegFrfMsb = 0x06,
+        RegFrfMid = 0x07,
+        RegFrfLsb = 0x08,
+        RegPaConfig = 0x09,
+        RegPaRamp = 0x0A,
+        RegOcp = 0x0B,
+        RegLna = 0x0C,
+        RegRxConfig = 0x0D,
+        RegRssiConfig = 0x0E,
+        RegRssiCollision = 0x0F,
+        RegRssiThresh = 0x10,
+        RegRssiValue = 0x11,
+        RegRxBw = 0x12,
+        RegAfcBw = 0x13,
+        RegOokPeak = 0x14,
+        RegOokFix = 0x15,
+        RegOokAvg = 0x16,
+        RegAfcFei = 0x1A,
+        RegFeiMsb = 0x1D,
+        RegPreambleDetect = 0x1F,
+        RegPreambleMsb = 0x25,
+        RegPreambleLsb = 0x26,
+        RegSyncConfig = 0x27,
+        RegSyncValue1 = 0x28,
+        RegPacketConfig1 = 0x30,
+        RegPacketConfig2 = 0x31,
+        RegPayloadLength = 0x32,
+        RegFifoThresh = 0x35,
+        RegIrqFlags1 = 0x3E,
+        RegIrqFlags2 = 0x3F,
+        RegDioMapping1 = 0x40,
+        RegVersion = 0x42,
+        RegPaDac = 0x4D,
+
+        // LoRa mode, 0x0D - 0x3F are mapped to the LoRa modem
+        RegLoraFifoAddrPtr = 0x0D,
+        RegLoraFifoTxBaseAddr = 0x0E,
+        RegLoraFifoRxBaseAddr = 0x0F,
+        RegLoraFifoRxCurrentAddr = 0x10,
+        RegLoraIrqFlagsMask = 0x11,
+        RegLoraIrqFlags = 0x12,
+        RegLoraRxNbBytes = 0x13,
+        RegLoraPktSnrValue = 0x19,
+        RegLoraPktRssiValue = 0x1A,
+        RegLoraModemConfig1 = 0x1D,
+        RegLoraModemConfig2 = 0x1E,
+        RegLoraSymbTimeoutLsb = 0x1F,
+        RegLoraPreambleMsb = 0x20,
+        RegLoraPreambleLsb = 0x21,
+        RegLoraPayloadLength = 0x22,
+        RegLoraMaxPayloadLength = 0x23,
+        RegLoraModemConfig3 = 0x26,
+        RegLoraDetectOptimize = 0x31,
+        RegLoraDetectionThreshold = 0x37,
+        RegLoraSyncWord = 0x39
+    };
+
+    ~Rfm9x();
+    void begin(const uint8_t pinSS, const uint8_t pinDio0 = NOPIN, const uint8_t pinDio2 = NOPIN);
+    void loop();
+    void stop();
+    void setModulation(const Modulation modulation);
+    bool setLora(const LoraConfig &cfg);
+    bool isLora() const { return (opMode & (1<<7)) != 0; }
+    void setRxBandwidth(const uint32_t bw_hz);
+    void setRssiThreshold(const uint8_t thresh);
+    void setPreamble(const uint16_t len);
+    void setFifoThreshold(const uint8_t thresh);
+    void setSync(const uint8_t *sync, const int syncsize);
+    void setTxPower(const int8_t power);
+    void setFreq(const uint32_t freq_hz);
+    void setBitrate(const uint16_t bit_s);
+
+    void send(const uint8_t *data, const int size, const bool varSize = true);
+    void txTest(const uint32_t freq_hz, const int16_t f_corr, const int8_t pwr, const uint16_t baud);
+
+    bool isIdle();
+    bool isModeReady();
     void startReceive(const int size = -1);
+    bool startReceiveContinuous();
     bool payloadReady();
     uint8_t getPayload(uint8_t *buf);
     uint8_t getPayload(uint8_t *buf, const uint8_t maxlen);
     int8_t getRssi();
+    int8_t getSnr() { return snr; }
     FifoLevel getFifoLevel();
     void writeFifo(const uint8_t *buf, uint8_t len);
 };
@@ -0,0 +1,83 @@
+#pragma once
+/**
+ * @brief host stand-in for the Arduino core, only what the application sources use
+ * Flash is ordinary memory, time is taken from the host's steady clock. delay() does not sleep,
+ * it advances millis() / micros(), so timeouts can be skipped without waiting. GPIO levels are
+ * kept per pin, interrupts are raised by simulated devices only.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "Print.h"
+#include "WString.h"
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t *>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t *>(addr))
+#define pgm_read_float(addr) (*reinterpret_cast<const float *>(addr))
+#define pgm_read_ptr(addr) (*(void * const *)(addr))
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strlen_P strlen
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+inline void yield() {}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode) {}
+void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t interrupt);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class HardwareSerial: public Print {
+public:
+    void begin(unsigned long baud) {}
+    size_t write(uint8_t c);
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @brief device side of the GPIOs, for simulated chips like src/sim/rfm69sim
+ * A hook is called on every digitalWrite() of its pin. mockPinInput() sets the level of an input
+ * and runs an attached interrupt handler, micros() returns atUs while the handler runs.
+ * The time hooks are called by micros() outside interrupt handlers, so a device can raise the
+ * interrupts due until then like the hardware would have done. Each device registers one time
+ * hook with its arg, a nullptr hook removes it.
+ */
+typedef void (*MockPinHook)(void *arg, uint8_t val);
+void mockPinHook(uint8_t pin, MockPinHook hook, void *arg);
+void mockPinInput(uint8_t pin, uint8_t val, unsigned long atUs);
+typedef void (*MockTimeHook)(void *arg);
+void mockTimeHook(MockTimeHook hook, void *arg);
@@ -0,0 +1,141 @@
+#include <Arduino.h>
+#include <SPI.h>
+#include <ESP8266WiFi.h>
+#include <chrono>
+#include <stdio.h>
+
+HardwareSerial Serial;
+SPIClass SPI;
+ESP8266WiFiClass WiFi;
+
+static const auto startTime = std::chrono::steady_clock::now();
+static unsigned long skippedUs = 0; // time added by delay()
+static bool isrActive = false;
+static unsigned long isrUs = 0; // micros() while an interrupt handler runs
+static const uint8_t TIMEHOOKS = 4;
+static struct {
+    MockTimeHook hook;
+    void *arg;
+} timeHooks[TIMEHOOKS];
+static bool inTimeHook = false;
+
+static const uint8_t PINS = 17; // GPIO0 - GPIO16
+
+static struct {
+    uint8_t level;
+    MockPinHook hook;
+    void *hookArg;
+    void (*isr)(void *);
+    void *isrArg;
+    int isrMode;
+} pins[PINS];
+
+unsigned long micros() {
+    if (isrActive)
+        return isrUs;
+
+    const auto elapsed = std::chrono::steady_clock::now() - startTime;
+    const unsigned long now = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + skippedUs;
+    if (!inTimeHook) {
+        inTimeHook = true;
+        for (auto &th : timeHooks)
+            if (th.hook != nullptr)
+                th.hook(th.arg);
+        inTimeHook = false;
+    }
+    return now;
+}
+
+unsigned long millis() {
+    return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+    skippedUs += ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+    skippedUs += us;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin >= PINS)
+        return;
+    pins[pin].level = val;
+    if (pins[pin].hook != nullptr)
+        pins[pin].hook(pins[pin].hookArg, val);
+}
+
+int digitalRead(uint8_t pin) {
+    return (pin < PINS) ? pins[pin].level : LOW;
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode) {
+    if (pin >= PINS)
+        return;
+    pins[pin].isr = isr;
+    pins[pin].isrArg = arg;
+    pins[pin].isrMode = mode;
+}
+
+void detachInterrupt(uint8_t interrupt) {
+    if (interrupt < PINS)
+        pins[interrupt].isr = nullptr;
+}
+
+void mockPinHook(uint8_t pin, MockPinHook hook, void *arg) {
+    if (pin >= PINS)
+        return;
+    pins[pin].hook = hook;
+    pins[pin].hookArg = arg;
+}
+
+void mockTimeHook(MockTimeHook hook, void *arg) {
+    for (auto &th : timeHooks)
+        if ( (th.hook != nullptr) && (th.arg == arg) )
+            th.hook = nullptr;
+    if (hook == nullptr)
+        return;
+
+    for (auto &th : timeHooks) {
+        if (th.hook == nullptr) {
+            th.hook = hook;
+            th.arg = arg;
+            return;
+        }
+    }
+}
+
+void mockPinInput(uint8_t pin, uint8_t val, unsigned long atUs) {
+    if (pin >= PINS)
+        return;
+    const uint8_t old = pins[pin].level;
+    pins[pin].level = val;
+    if ( (pins[pin].isr == nullptr) || isrActive || (old == val) )
+        return;
+
+    const int mode = pins[pin].isrMode;
+    if ( (mode == CHANGE) || ((mode == RISING) && (val == HIGH)) || ((mode == FALLING) && (val == LOW)) ) {
+        isrActive = true;
+        isrUs = atUs;
+        pins[pin].isr(pins[pin].isrArg);
+        isrActive = false;
+    }
+}
+
+/**
+ * @brief one byte on the bus, advances micros() by the bus time of 8 clocks
+ */
+uint8_t SPIClass::shift(uint8_t data) {
+    if (device == nullptr)
+        return 0;
+
+    pendingNs += 8000000000ULL / frequency;
+    delayMicroseconds(pendingNs / 1000);
+    pendingNs %= 1000;
+    return device->transfer(data);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <Arduino.h>
+
+class IPAddress {
+public:
+    bool isSet() const { return true; }
+    String toString() const { return F("127.0.0.1"); }
+};
+
+class ESP8266WiFiClass {
+public:
+    IPAddress localIP() { return IPAddress(); }
+};
+
+extern ESP8266WiFiClass WiFi;
@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+enum WebRequestMethod {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010
+};
+
+class AsyncWebServerRequest {
+public:
+    String url() const { return String(); }
+    WebRequestMethod method() const { return HTTP_GET; }
+    void send(int code, const String &contentType = String(), const String &content = String()) {}
+};
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+    virtual bool canHandle(AsyncWebServerRequest *request) { return false; }
+    virtual void handleRequest(AsyncWebServerRequest *request) {}
+    virtual void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {}
+};
+
+class AsyncWebServer {
+public:
+    AsyncWebHandler &addHandler(AsyncWebHandler *handler) { return *handler; }
+    bool removeHandler(AsyncWebHandler *handler) { return true; }
+};
+
+/**
+ * @brief websocket without clients, messages are counted and dropped
+ */
+class AsyncWebSocket {
+public:
+    uint32_t messages = 0;
+    void textAll(const String &message) { messages++; }
+};
@@ -0,0 +1,55 @@
+#include "Arduino.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+size_t Print::write(const uint8_t *buf, size_t size) {
+    size_t n = 0;
+    while (size-- > 0)
+        n += write(*buf++);
+    return n;
+}
+
+size_t Print::write(const char *str) {
+    return write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+}
+
+size_t Print::print(const char *str) {
+    return write(str);
+}
+
+size_t Print::print(const __FlashStringHelper *str) {
+    return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const String &str) {
+    return write(str.c_str());
+}
+
+size_t Print::print(char c) {
+    return write((uint8_t) c);
+}
+
+size_t Print::print(long n, int base) {
+    return print(String(n, base));
+}
+
+size_t Print::print(unsigned long n, int base) {
+    return print(String(n, base));
+}
+
+size_t Print::print(double n, int digits) {
+    return print(String(n, digits));
+}
+
+size_t Print::println() {
+    return write("\r\n");
+}
+
+size_t Print::printf(const char *format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return write(buf);
+}
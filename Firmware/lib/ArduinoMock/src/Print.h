@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+class String;
+class __FlashStringHelper;
+
+#define DEC 10
+#define HEX 16
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size);
+    size_t write(const char *str);
+    size_t print(const char *str);
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const String &str);
+    size_t print(char c);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(int n, int base = DEC) { return print((long) n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(double n, int digits = 2);
+    size_t println();
+    template<typename T> size_t println(const T &val) { return print(val) + println(); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief MQTT client which is always connected and drops all messages
+ * Published messages and payload bytes are counted, publishDelayUs makes publishing block like a
+ * slow connection to the broker.
+ */
+class PubSubClient: public Print {
+public:
+    uint32_t published = 0;
+    uint32_t payloadBytes = 0;
+    uint32_t publishDelayUs = 0;
+    bool connected() { return true; }
+    bool publish(const char *topic, const char *payload, bool retained = false) {
+        delayMicroseconds(publishDelayUs);
+        published++;
+        payloadBytes += strlen(payload);
+        return true;
+    }
+    bool beginPublish(const char *topic, unsigned int plength, bool retained) {
+        delayMicroseconds(publishDelayUs);
+        published++;
+        return true;
+    }
+    size_t write(uint8_t c) {
+        payloadBytes++;
+        return 1;
+    }
+    size_t write(const uint8_t *buf, size_t size) {
+        payloadBytes += size;
+        return size;
+    }
+    int endPublish() { return 1; }
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief chip on the mock SPI bus, selected by its own chipselect pin (see mockPinHook())
+ */
+class SPIDevice {
+public:
+    virtual ~SPIDevice() {}
+    virtual uint8_t transfer(uint8_t data) = 0;
+};
+
+/**
+ * @brief SPI bus, bytes are exchanged with the attached SPIDevice, reads return 0 without device
+ * With a device attached, the time of shifting the bytes at the bus clock is added to micros().
+ */
+class SPIClass {
+private:
+    SPIDevice *device = nullptr;
+    uint32_t frequency = 1000000; // ESP8266 default
+    uint32_t pendingNs = 0; // bus time not yet added to micros()
+    uint8_t shift(uint8_t data);
+public:
+    void begin() {}
+    void end() {}
+    void setFrequency(uint32_t freq) { frequency = freq; }
+    void setDevice(SPIDevice *dev) { device = dev; }
+    uint8_t transfer(uint8_t data) { return shift(data); }
+    uint16_t transfer16(uint16_t data) {
+        const uint8_t msb = shift(data >> 8);
+        return msb << 8 | shift(data & 0xFF);
+    }
+    void write(uint8_t data) { shift(data); }
+    void write16(uint16_t data) { transfer16(data); }
+    void transferBytes(const uint8_t *out, uint8_t *in, uint32_t size) {
+        for (uint32_t i=0; i<size; i++) {
+            const uint8_t data = shift(out != nullptr ? out[i] : 0xFF);
+            if (in != nullptr)
+                in[i] = data;
+        }
+    }
+    void writeBytes(const uint8_t *data, uint32_t size) {
+        for (uint32_t i=0; i<size; i++)
+            shift(data[i]);
+    }
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,82 @@
+#include "Arduino.h"
+#include <stdio.h>
+
+std::string String::fromLong(long val, int base) {
+    if (val < 0 && base == DEC)
+        return '-' + fromULong(-(unsigned long) val, base);
+    return fromULong(val, base);
+}
+
+std::string String::fromULong(unsigned long val, int base) {
+    char buf[8 * sizeof(val) + 1];
+    char *p = &buf[sizeof(buf) - 1];
+    *p = 0;
+    do {
+        const uint8_t digit = val % base;
+        *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        val /= base;
+    } while (val != 0);
+    return p;
+}
+
+String::String(double val, unsigned char decimalPlaces) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, val);
+    s = buf;
+}
+
+bool String::endsWith(const String &suffix) const {
+    return (s.size() >= suffix.s.size()) && (s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0);
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    const size_t pos = s.find(ch, fromIndex);
+    return pos == std::string::npos ? -1 : (int) pos;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const {
+    const size_t pos = s.find(str.s, fromIndex);
+    return pos == std::string::npos ? -1 : (int) pos;
+}
+
+int String::lastIndexOf(char ch) const {
+    const size_t pos = s.rfind(ch);
+    return pos == std::string::npos ? -1 : (int) pos;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        const unsigned int tmp = endIndex;
+        endIndex = beginIndex;
+        beginIndex = tmp;
+    }
+    if (beginIndex >= s.size())
+        return String();
+    if (endIndex > s.size())
+        endIndex = s.size();
+    return String(s.substr(beginIndex, endIndex - beginIndex).c_str());
+}
+
+void String::toLowerCase() {
+    for (char &c : s)
+        c = tolower(c);
+}
+
+void String::toUpperCase() {
+    for (char &c : s)
+        c = toupper(c);
+}
+
+void String::trim() {
+    const size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        s.clear();
+        return;
+    }
+    s = s.substr(begin, s.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < s.size())
+        s.erase(index, count);
+}
@@ -0,0 +1,101 @@
+#pragma once
+/**
+ * @brief Arduino String on top of std::string
+ * std::string's small string buffer (15 chars) is a bit larger than the one of the ESP8266 core
+ * (11 chars), so allocation counts of short strings are slightly optimistic.
+ */
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include "Print.h"
+
+class __FlashStringHelper;
+
+class String {
+private:
+    std::string s;
+    static std::string fromLong(long val, int base);
+    static std::string fromULong(unsigned long val, int base);
+public:
+    String() {}
+    String(const char *cstr) : s(cstr != nullptr ? cstr : "") {}
+    String(const __FlashStringHelper *str) : String(reinterpret_cast<const char *>(str)) {}
+    String(const String &str) = default;
+    String(String &&str) = default;
+    explicit String(char c) : s(1, c) {}
+    explicit String(unsigned char val, unsigned char base = DEC) : s(fromULong(val, base)) {}
+    explicit String(int val, unsigned char base = DEC) : s(fromLong(val, base)) {}
+    explicit String(unsigned int val, unsigned char base = DEC) : s(fromULong(val, base)) {}
+    explicit String(long val, unsigned char base = DEC) : s(fromLong(val, base)) {}
+    explicit String(unsigned long val, unsigned char base = DEC) : s(fromULong(val, base)) {}
+    explicit String(short val, unsigned char base = DEC) : String((int) val, base) {}
+    explicit String(unsigned short val, unsigned char base = DEC) : String((unsigned int) val, base) {}
+    explicit String(signed char val, unsigned char base = DEC) : String((int) val, base) {}
+    explicit String(long long val, unsigned char base = DEC) : String((long) val, base) {}
+    explicit String(unsigned long long val, unsigned char base = DEC) : String((unsigned long) val, base) {}
+    explicit String(double val, unsigned char decimalPlaces = 2);
+    explicit String(float val, unsigned char decimalPlaces = 2) : String((double) val, decimalPlaces) {}
+
+    String &operator=(const String &rhs) = default;
+    String &operator=(String &&rhs) = default;
+    String &operator=(const char *cstr) { s = cstr != nullptr ? cstr : ""; return *this; }
+    String &operator=(const __FlashStringHelper *str) { return *this = reinterpret_cast<const char *>(str); }
+
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+    unsigned int length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    const char *c_str() const { return s.c_str(); }
+    void clear() { s.clear(); }
+
+    bool concat(const String &str) { s += str.s; return true; }
+    bool concat(const char *cstr) { if (cstr != nullptr) s += cstr; return true; }
+    bool concat(const char *cstr, unsigned int length) { s.append(cstr, length); return true; }
+    bool concat(const __FlashStringHelper *str) { return concat(reinterpret_cast<const char *>(str)); }
+    bool concat(char c) { s += c; return true; }
+    template<typename T> bool concat(T val) { return concat(String(val)); }
+    template<typename T> String &operator+=(const T &rhs) { concat(rhs); return *this; }
+
+    int compareTo(const String &str) const { return s.compare(str.s); }
+    bool equals(const String &str) const { return s == str.s; }
+    bool operator==(const String &rhs) const { return s == rhs.s; }
+    bool operator==(const char *cstr) const { return s == (cstr != nullptr ? cstr : ""); }
+    bool operator==(const __FlashStringHelper *str) const { return *this == reinterpret_cast<const char *>(str); }
+    bool operator!=(const String &rhs) const { return !(*this == rhs); }
+    bool operator!=(const char *cstr) const { return !(*this == cstr); }
+    bool operator<(const String &rhs) const { return s < rhs.s; }
+    bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String &suffix) const;
+
+    char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index) { return s[index]; }
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const String &str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char ch) const;
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, s.size()); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+    void remove(unsigned int index, unsigned int count = (unsigned int) -1);
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    double toDouble() const { return atof(s.c_str()); }
+
+    friend String operator+(const String &lhs, const String &rhs) { String r(lhs); r.concat(rhs); return r; }
+    friend String operator+(const String &lhs, const char *rhs) { String r(lhs); r.concat(rhs); return r; }
+    friend String operator+(const String &lhs, const __FlashStringHelper *rhs) { String r(lhs); r.concat(rhs); return r; }
+    friend String operator+(const String &lhs, char rhs) { String r(lhs); r.concat(rhs); return r; }
+    friend String operator+(const char *lhs, const String &rhs) { String r(lhs); r.concat(rhs); return r; }
+    friend String operator+(const __FlashStringHelper *lhs, const String &rhs) { String r(lhs); r.concat(rhs); return r; }
+    friend String operator+(char lhs, const String &rhs) { String r(lhs); r.concat(rhs); return r; }
+    template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    friend String operator+(const String &lhs, T rhs) { String r(lhs); r.concat(String(rhs)); return r; }
+};
+
+class StringSumHelper: public String {
+public:
+    using String::String;
+    StringSumHelper(const String &str) : String(str) {}
+};
@@ -1,60 +1,40 @@
 #include "868gw.h"
-
-enum Gw868RxModes: uint8_t {
-    RXMODE_TX29,        // Technloline TX21, TX25, TX27, TX29, TX37, 17241 bit/s
-    RXMODE_TX35,        // Technoline TX35, 9579 bit/s
-    RXMODE_TX22,        // TX22, 8842 bit/s
-    RXMODE_EC3K,        // voltcraft energycount
-    RXMODE_BRESSER,     // Bresser 7-in-1
-    RXMODE_EMT7170      // EMT 7110, 9579 bit/s
-};
-
-static const struct {
-    Gw868RxModes mode;
-    uint16_t bitrate;
-    uint8_t sync[8];
-    uint8_t syncLen;
-    uint8_t rxLen;
-} MODETAB[] = {
-    {RXMODE_TX29,       17241, {0x2D, 0xD4}, 2, 5},
-    {RXMODE_TX35,       9579, {0x2D, 0xD4}, 2, 5},
-    {RXMODE_TX22,       8842, {0x2D, 0xD4}, 2, 5},
-    {RXMODE_EC3K,       20000, {0x13, 0xF1, 0x85, 0xD3, 0xAC}, 5, 60},
-    {RXMODE_BRESSER,    8000, {0x2D, 0xD4}, 2, 25},
-    {RXMODE_EMT7170,    9579, {0x2D, 0xD4}, 2, 12}
-};
-
-RadioApplication *radioapp = nullptr;
+#include "checksum.h"
+#include "ec3kframe.h"
+
+const uint8_t TRACKWEIGHT = 4; // new frames contribute 1 / TRACKWEIGHT to the offset estimate
+const uint8_t TRACKMINFRAMES = 3; // frames of a transmitter until its offset is followed
+const uint32_t TRACKTIMEOUT = 3600000UL; // ms, transmitters not heard for longer are not followed
+const int32_t OFFSETSTEP = 1000; // Hz, carrier is moved in steps of this size
+const uint32_t PERIODMIN = 1000; // ms, frames closer together are repeats
+const uint32_t PERIODMAX = 300000; // ms, longer gaps don't tell the period
+const uint32_t SCHEDGUARD = 250; // ms, receiver waits this long before and after a due frame
+const uint8_t SCHEDMAXMISSES = 8; // transmitters missed more often are left to discovery
+const uint8_t NORXMODE = 0xFF;
+const uint8_t SAMPLEFIFOTHRESH = 32; // FIFO is read in bursts of SAMPLEFIFOTHRESH + 1 samples
 
 class LaCrosseDecoder {
 public:
-    static bool decode(const uint8_t *data, const size_t len, const int8_t rssi) {
+    static Gw868DecodeResult decode(uint8_t *data, const size_t len, RxFrame &rx) {
         if (len < 5)
-            return false;
-
-        uint8_t crc8 = 0;
-        for (int i = 0; i < 5; i++) {
-            crc8 ^= data[i];
-            for (int j = 0; j < 8; j++)
-            if ((crc8 & 0x80) != 0)
-                crc8 = (crc8 << 1) ^ 0x31;
-            else
-                crc8 <<= 1;
-        }
-        if (crc8 != 0)
-            return false;
+            return GW868DECODE_INVALID;
 
+        if (crc8(data, 5) != 0)
+            return GW868DECODE_CHECKSUM;
+
+        rx.id = getId(data);
+        return GW868DECODE_OK;
+    }
+
+    static void publish(const uint8_t *data, const RxFrame &rx) {
         uint8_t nibbles[10];
         for (uint8_t i = 0; i < sizeof(nibbles); i++) {
             nibbles[i] = (data[i / 2] >> (4 - ((i % 2) * 4))) & 0x0F;
         }
 
-        uint16_t id = (nibbles[1] << 4 | nibbles[2]) & 0xFC;
+        uint16_t id = rx.id;
         int16_t t = nibbles[3] * 100 + nibbles[4] * 10 + nibbles[5] - 400;
         uint8_t rh = (nibbles[6] << 4 | nibbles[7]) & 0x7F;
-        if (rh == 0x7d) // flag for second temperature sensor (TX-25)
-            id += 0x100;
-
 
         bool init = (data[1] & 0x20) != 0;
         bool batlow = (data[3] & 0x80) != 0;
@@ -89,44 +69,63 @@ public:
 
             payload[F("batlow")] = batlow;
             payload[F("init")] = init;
+            payload[F("freqOffset")] = rx.offset;
 
             mqtt.beginPublish((topic + "state").c_str(), measureJson(payload), false);
             serializeJson(payload, mqtt);
             mqtt.endPublish();
         }
+    }
+private:
+    static uint16_t getId(const uint8_t *data) {
+        uint16_t id = (data[0] << 4 | data[1] >> 4) & 0xFC;
+        if ((data[3] & 0x7F) == 0x7d) // flag for second temperature sensor (TX-25)
+            id += 0x100;
+        return id;
+    }
+};
+
+/**
+ * @brief TX22 frames are received and logged, but not decoded yet
+ * Their layout differs from the other LaCrosse sensors, so LaCrosseDecoder would publish misread
+ * values. Nothing is accepted, the frames count neither as decoded nor as checksum errors.
+ */
+class Tx22Decoder {
+public:
+    static Gw868DecodeResult decode(uint8_t *data, const size_t len, RxFrame &rx) {
+        return GW868DECODE_INVALID;
+    }
 
-        return true;
+    static void publish(const uint8_t *data, const RxFrame &rx) {
     }
 };
 
 class EC3KDecoder {
 public:
-    static bool decode(uint8_t *buf, const size_t len, const int8_t rssi) {
-        const uint8_t PAYLOADLEN = 41;
+    static const uint8_t PAYLOADLEN = 41;
 
+    /**
+     * @brief unframes in place, the payload starts at data[1]
+     */
+    static Gw868DecodeResult decode(uint8_t *buf, const size_t len, RxFrame &rx) {
         if (len < (PAYLOADLEN + 2)) // payload len + 2x HDLC flag
-            return false;
+            return GW868DECODE_INVALID;
 
-        descramble(buf, len);
-        if (buf[0] != 0x7e)
-            return false; // no HDLC frame!
+        if (ec3kUnframe(buf, len) != PAYLOADLEN)
+            return GW868DECODE_INVALID;
 
-        uint8_t *payload = &buf[1];
-        int l = unstuffrev(payload, len - 1);
+        if (crcCcitt(&buf[1], PAYLOADLEN) != 0xF0B8)
+            return GW868DECODE_CHECKSUM;
 
-        if (l != PAYLOADLEN)
-            return false;
-      
-        uint16_t crc = 0xFFFF;
-        for (size_t i = 0; i<PAYLOADLEN; i++)
-            crc = crc_ccitt_update(crc, payload[i]);
+        rx.id = getWord(&buf[1], 4);
+        return GW868DECODE_OK;
+    }
 
-        if ( (crc != 0xF0B8) )
-            return false;
-        
+    static void publish(const uint8_t *buf, const RxFrame &rx) {
+        const uint8_t *payload = &buf[1];
         String line = F("EC3K ID ");
 
-        uint16_t id = getWord(&payload[0], 4);
+        uint16_t id = rx.id;
         line += String(id, HEX);
         
         line += F(", P: ");
@@ -156,12 +155,12 @@ public:
 
             payload[F("E")] = eDbl;
             mqtt.publish((topic + "E").c_str(), String(eDbl, 6).c_str());
+            payload[F("freqOffset")] = rx.offset;
 
             mqtt.beginPublish((topic + F("state")).c_str(), measureJson(payload), false);
             serializeJson(payload, mqtt);
             mqtt.endPublish();
         }
-        return true;
     }
 private:
     uint16_t static getWord(const uint8_t *buf, const uint8_t offset = 0) {
@@ -172,89 +171,28 @@ private:
         result |= buf[2] >> (8 - offset);
         return result;
     }
-
-    static uint16_t crc_ccitt_update(uint16_t crc, uint8_t data) {
-        data ^= crc & 0xFF;
-        data ^= data << 4;
-
-        return ((((uint16_t) data << 8) | (crc >> 8)) ^ (uint8_t) (data >> 4)
-                ^ ((uint16_t) data << 3));
-    }
-
-    static uint8_t count1bits(const uint32_t v) {
-        uint32_t tmp = v;
-        uint8_t result = 0;
-        while (tmp != 0) {
-            result++;
-            tmp &= tmp - 1;
-        }
-        return result;
-    }
-
-    static void descramble(uint8_t *buf, const size_t len) {
-        uint32_t lfsr = 0xF185D3AC;
-        const uint32_t POLY = 0x31801;
-        for (size_t i = 0; i < len; i++) {
-            uint8_t ob = 0;
-            for (uint8_t bit = 0; bit < 8; bit++) {
-                uint8_t inbit = (buf[i] >> 7) & 0x01;
-                uint8_t outbit = inbit ^ (count1bits(lfsr & POLY) & 0x01);
-                lfsr = lfsr << 1 | inbit;
-                buf[i] <<= 1;
-                ob = ob << 1 | outbit;
-            }
-            buf[i] = ob ^ 0xFF;
-        }
-    }
-
-    static int unstuffrev(uint8_t *buf, const size_t len) {
-        uint8_t cnt1bits = 0;
-        uint8_t ob = 0;
-        uint8_t iob = 0;
-        uint8_t *po = buf;
-        for (size_t i = 0; i < len; i++) {
-            for (uint8_t bit = 0; bit < 8; bit++) {
-                uint8_t inbit = buf[i] & 0x80;
-                buf[i] <<= 1;
-                if ( (cnt1bits >= 5) && (inbit == 0) ) {
-                    if (cnt1bits == 6)
-                        return (po - buf);
-                    cnt1bits = 0;
-                    continue;
-                }
-                if (inbit)
-                    cnt1bits++;
-                else
-                    cnt1bits = 0;
-
-                ob >>= 1;
-                ob |= inbit;
-                iob++;
-                if (iob == 8) {
-                    iob = 0;
-                    *po++ = ob;
-                }
-            }
-        }
-        return -1;
-    }
 };
 
 class EMT7170Decoder {
 public:
-    static bool decode(const uint8_t *data, const size_t len, const int8_t rssi) {
+    static Gw868DecodeResult decode(uint8_t *data, const size_t len, RxFrame &rx) {
         if (len < 12)
-            return false;
+            return GW868DECODE_INVALID;
 
         uint8_t check = 0;
         for (uint8_t i = 0; i<12; i++)
             check += data[i];
         
         if (check != 0)
-            return false;
+            return GW868DECODE_CHECKSUM;
+
+        rx.id = data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
+        return GW868DECODE_OK;
+    }
 
+    static void publish(const uint8_t *data, const RxFrame &rx) {
         String line = F("EMT7170 ID ");
-        uint32_t id = data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
+        uint32_t id = rx.id;
         line += String(id, HEX);
 
         double w = ((data[4] << 8 | data[5]) & 0x3FFF) / 2.0;
@@ -291,34 +229,41 @@ public:
 
             payload[F("E")] = e;
             mqtt.publish((topic + 'E').c_str(), String(e, 6).c_str());
+            payload[F("freqOffset")] = rx.offset;
 
             mqtt.beginPublish((topic + F("state")).c_str(), measureJson(payload), false);
             serializeJson(payload, mqtt);
             mqtt.endPublish();
         }
-
-        return true;
     }
 };
 
 class Bresser7in1Decoder {
 public:
-    static bool decode(uint8_t *data, const size_t len, const int8_t rssi) {
+    /**
+     * @brief descrambles in place
+     */
+    static Gw868DecodeResult decode(uint8_t *data, const size_t len, RxFrame &rx) {
         if (len < 25)
-            return false;
+            return GW868DECODE_INVALID;
 
         for (size_t i=0; i<25; i++)
             data[i] ^= 0xAA;
 
-        uint16_t dig = lfsr_digest16(&data[2], 23, 0x8810, 0xba95);
+        uint16_t dig = bresserDigest(&data[2], 23);
         uint16_t msgdig = data[0] << 8 | data[1];
 
         if ( (dig ^ msgdig) != 0x6df1)
-            return false;
+            return GW868DECODE_CHECKSUM;
+
+        rx.id = data[2] << 8 | data[3];
+        return GW868DECODE_OK;
+    }
 
+    static void publish(const uint8_t *data, const RxFrame &rx) {
         String line = F("Bresser7in1 ID: ");
 
-        uint16_t id = data[2] << 8 | data[3];
+        uint16_t id = rx.id;
         line += String(id, HEX);
         
         int16_t t_raw = bcdToInt(&data[14], 3);
@@ -372,13 +317,12 @@ public:
             payload[F("Ev")] = ev;
             payload[F("UVidx")] = uvIndex;
             payload[F("batlow")] = batlow;
+            payload[F("freqOffset")] = rx.offset;
 
             mqtt.beginPublish((topic + F("state")).c_str(), measureJson(payload), false);
             serializeJson(payload, mqtt);
             mqtt.endPublish();
         }
-
-        return true;
     }
 private:
     static uint32_t bcdToInt(const uint8_t *buf, const uint8_t digits, const bool shift = false) {
@@ -390,115 +334,576 @@ private:
         }
         return result;
     }
-    static uint16_t lfsr_digest16(const uint8_t *buf, const size_t len, const uint16_t gen, const uint16_t key) {
-        uint16_t sum = 0;
-        uint16_t k = key;
-        for (size_t i=0; i<len; i++) {
-            for (int b=7; b>=0; b--) {
-                if ( ((buf[i] >> b) & 1) > 0 )
-                    sum ^= k;
-
-                if ( (k & 0x01) != 0 )
-                    k = (k >> 1) ^ gen;
-                else
-                    k >>= 1;
-            }
-        }
-        return sum;
-    }
 
 };
 
-Gw868::Gw868(const JsonObject &conf):
-        currentRxMode(-1),
-        nextSwitch(0) {
-    rfm69->setFreq(868300000UL);
+typedef Gw868DecodeResult (*Gw868Decode)(uint8_t *data, const size_t len, RxFrame &rx);
+typedef void (*Gw868Publish)(const uint8_t *data, const RxFrame &rx);
+
+static constexpr char NAME_TX29[] PROGMEM = "TX29"; // Technoline TX21, TX25, TX27, TX29, TX37
+static constexpr char NAME_TX35[] PROGMEM = "TX35";
+static constexpr char NAME_TX22[] PROGMEM = "TX22";
+static constexpr char NAME_EC3K[] PROGMEM = "EC3K"; // Voltcraft Energycount 3000
+static constexpr char NAME_BRESSER[] PROGMEM = "Bresser7in1";
+static constexpr char NAME_EMT7170[] PROGMEM = "EMT7170"; // EMT 7110, 7170
+
+/**
+ * @brief decoder registry, the position of a decoder is its bit in the rxmodes setting, so new
+ * decoders are appended
+ * Decoders with the same bitrate and sync word are received in one mode, with the longest frame
+ * length of them. decode checks a frame without side effects, publish runs later from loop() on
+ * the frame as decode left it.
+ */
+static const struct DecoderEntry {
+    PGM_P name;
+    uint16_t bitrate;
+    uint8_t sync[8];
+    uint8_t syncLen;
+    uint8_t frameLen;
+    Gw868Decode decode;
+    Gw868Publish publish;
+} DECODERS[] = {
+    {NAME_TX29,     17241, {0x2D, 0xD4}, 2, 5, LaCrosseDecoder::decode, LaCrosseDecoder::publish},
+    {NAME_TX35,     9579, {0x2D, 0xD4}, 2, 5, LaCrosseDecoder::decode, LaCrosseDecoder::publish},
+    {NAME_TX22,     8842, {0x2D, 0xD4}, 2, 5, Tx22Decoder::decode, Tx22Decoder::publish},
+    {NAME_EC3K,     20000, {0x13, 0xF1, 0x85, 0xD3, 0xAC}, 5, 60, EC3KDecoder::decode, EC3KDecoder::publish},
+    {NAME_BRESSER,  8000, {0x2D, 0xD4}, 2, 25, Bresser7in1Decoder::decode, Bresser7in1Decoder::publish},
+    {NAME_EMT7170,  9579, {0x2D, 0xD4}, 2, 12, EMT7170Decoder::decode, EMT7170Decoder::publish}
+};
+static_assert(sizeof(DECODERS) / sizeof(DECODERS[0]) == GW868DECODERS, "GW868DECODERS doesn't match the decoder registry");
+static_assert(GW868DECODERS <= 16, "rxModes and modeDecoders have a bit per decoder");
 
-    Rfm69::Rfm69Config cfg[] = {
-        {Rfm69::RegRxBw, 2<<5 | Rfm69::RXBWFSK_250KHZ},
-        {Rfm69::RegRssiThresh, 195}, // /-0.5 dBm
-        {Rfm69::RegDataModul, 0<<3}, // packet mode, FSK
-        
-        {Rfm69::RegPacketConfig1, 0x00}, // fixed or unlimited length, no whitening, no crc
-    };
-    rfm69->writeConfig(cfg, sizeof(cfg) / sizeof(cfg[0]));
+static bool sameRxMode(const DecoderEntry &a, const DecoderEntry &b) {
+    return (a.bitrate == b.bitrate) && (a.syncLen == b.syncLen) && (memcmp(a.sync, b.sync, a.syncLen) == 0);
+}
 
-    rxModes = conf[F("rxmodes")];
+Gw868::Gw868(RfmBase *radio, const JsonObject &conf):
+        RadioApplication(radio),
+        capture(conf[F("capture")].as<uint8_t>() == GW868CAPTURE_SAMPLES ? GW868CAPTURE_SAMPLES : GW868CAPTURE_PACKET),
+        currentRxMode(-1),
+        discoveryRxMode(-1),
+        nextSwitch(0),
+        scheduled(false),
+        scheduledSwitches(0),
+        carrierOffset(0),
+        rxBw(GW868RXBW),
+        decoderStats(),
+        suspects(0),
+        lastDecodedMode(NORXMODE),
+        lastDecoded(0),
+        pendingHead(0),
+        pendingLen(0),
+        publishDrops(0),
+        fifoReadGapMax(0) {
+    radio->setFreq(GW868FREQ);
+
+    radio->setModulation(RfmBase::MODULATION_FSK);
+    radio->setRxBandwidth(rxBw);
+    radio->setRssiThreshold(195); // /-0.5 dBm
+
+    rxModes = conf[F("rxmodes")].as<uint16_t>() & ((1 << GW868DECODERS) - 1);
+    buildModes();
     interval = (conf[F("interval")] | 10) * 1000UL;
+    afc = conf[F("afc")] | false;
+    schedule = conf[F("schedule")] | true;
+    rxBwMin = conf[F("rxbwmin")] | 100000;
+    for (auto &sensor : sensors)
+        sensor.rxMode = NORXMODE;
+
+    if (capture == GW868CAPTURE_SAMPLES) {
+        afc = false; // without sync match there is no FEI
+        startSampling();
+    }
 }
 
 void Gw868::loop() {
-    if ((millis() >= nextSwitch)) {
-        nextSwitch = millis() + interval;
+    if (capture == GW868CAPTURE_SAMPLES) {
+        // the FIFO holds about 8 ms of samples, anything slow waits for publishPending()
+        const uint32_t now = micros();
+        if (now - lastFifoRead > fifoReadGapMax)
+            fifoReadGapMax = now - lastFifoRead;
+        lastFifoRead = now;
+
+        uint8_t buf[64];
+        demod.process(buf, radio->getPayload(buf, sizeof(buf)));
+
+        int8_t ch;
+        while ((ch = demod.nextFrame()) >= 0) {
+            handleFrame(demod.getTag(ch), demod.getFrame(ch), demod.getFrameLen(ch));
+            demod.releaseFrame(ch);
+        }
+        publishPending();
+        return;
+    }
+
+    const unsigned long now = millis();
+    const uint8_t due = schedule ? dueRxMode(now) : NORXMODE;
+    if (due != NORXMODE) {
+        scheduled = true;
+        if (due != currentRxMode) {
+            switchMode(due);
+            scheduledSwitches++;
+        }
+    }
+    else {
+        if (scheduled) {
+            scheduled = false;
+            if (currentRxMode != discoveryRxMode)
+                switchMode(discoveryRxMode);
+        }
+
+        if ((long) (now - nextSwitch) >= 0) {
+            nextSwitch = now + interval;
 
-        currentRxMode++;
-        while (true) {
-            if ( (rxModes & (1<<currentRxMode)) != 0) {
-                if ( (currentRxMode != RXMODE_EMT7170) || ((rxModes & (1<<RXMODE_TX35)) == 0) )
+            discoveryRxMode++;
+            while (true) {
+                if (discoveryRxMode >= GW868DECODERS)
+                    discoveryRxMode = 0;
+                if (modeDecoders[discoveryRxMode] != 0)
                     break;
+                discoveryRxMode++;
             }
 
-            currentRxMode++;
-            if (currentRxMode >= (sizeof(MODETAB) / sizeof(MODETAB[0])))
-                currentRxMode = 0;
+            auto mode = &DECODERS[discoveryRxMode];
+            String line;
+            line = F("Switch to mode ");
+            line += String(discoveryRxMode);
+            line += F(", ");
+            line += String(mode->bitrate);
+            line += F(" bit/s, synclen ");
+            line += String(mode->syncLen);
+            ws.textAll(line);
+
+            switchMode(discoveryRxMode);
         }
+    }
 
-        auto mode = &MODETAB[currentRxMode];
-        String line;
-        line = F("Switch to mode ");
-        line += String(currentRxMode);
-        line += F(", ");
-        line += String(mode->bitrate);
-        line += F(" bit/s, synclen ");
-        line += String(mode->syncLen);
-        ws.textAll(line);
+    if (radio->payloadReady()) {
+        uint8_t buf[60];
+        radio->getPayload(buf);
+        handleFrame(currentRxMode, buf, currentRxLen);
+        radio->startReceive(currentRxLen);
+    }
+    publishPending();
+}
 
-        rfm69->setBitrate(mode->bitrate);
-        rfm69->setSync(mode->sync, mode->syncLen);
-        currentRxLen = mode->rxLen;
-        if ( (currentRxMode == RXMODE_TX35) && ((rxModes & (1<<RXMODE_EMT7170)) != 0) ) {
-            currentRxLen = 12;
+/**
+ * @brief decodes a frame received in a mode, the transmitter is tracked if it decodes
+ * Logging and publishing are queued for publishPending(), so they don't delay the next FIFO read.
+ */
+void Gw868::handleFrame(const uint8_t rxMode, uint8_t *buf, const uint8_t len) {
+    PendingFrame *frame = queueFrame(false);
+    PendingFrame dropped;
+    if (frame == nullptr)
+        frame = &dropped; // decoded and tracked anyway, only the log line is lost
+
+    const uint32_t now = micros();
+    RxFrame &rx = frame->rx;
+    rx.rssi = radio->getRssi();
+    rx.offset = carrierOffset + ((capture == GW868CAPTURE_PACKET) ? radio->getFei() : 0);
+    rx.id = 0;
+    frame->rxMode = rxMode;
+    frame->decoder = NORXMODE;
+    frame->len = len;
+    memcpy(frame->raw, buf, len);
+
+    // decoders of longer frames first, their checksums cover more
+    uint16_t failed = 0; // decoders whose checksum didn't match
+    uint16_t pending = modeDecoders[rxMode];
+    while ( (frame->decoder == NORXMODE) && (pending != 0) ) {
+        uint8_t d = NORXMODE;
+        for (uint8_t i=0; i<GW868DECODERS; i++)
+            if ( ((pending & (1<<i)) != 0) && ((d == NORXMODE) || (DECODERS[i].frameLen > DECODERS[d].frameLen)) )
+                d = i;
+        pending &= ~(1<<d);
+
+        // decoders may modify the frame, each one gets the original
+        memcpy(frame->data, buf, len);
+
+        DecoderStats &stats = decoderStats[d];
+        const uint32_t start = micros();
+        const Gw868DecodeResult result = DECODERS[d].decode(frame->data, len, rx);
+        stats.cpuTime += micros() - start;
+        stats.frames++;
+        if (result == GW868DECODE_CHECKSUM)
+            failed |= 1<<d;
+        else if (result == GW868DECODE_OK) {
+            stats.decoded++;
+            frame->decoder = d;
         }
-        rfm69->startReceive(currentRxLen);
     }
 
-    if (rfm69->payloadReady()) {
-        uint8_t buf[60];
-        rfm69->getPayload(buf);
-        int rssi = rfm69->getRssi();
+    countChecksumErrors(rxMode, failed, frame->decoder != NORXMODE, now);
+    if (frame->decoder == NORXMODE)
+        return;
 
-        String line;
-        line = F("RFM payload: ");
-        
-        for (uint8_t i = 0; i < currentRxLen; i++) {
-            if (buf[i] < 0x10)
-                line += '0';
-            line += String(buf[i], HEX) + ' ';
+    if (frame == &dropped) {
+        // a decoded frame takes the place of a queued one that only logs its bytes
+        frame = queueFrame(true);
+        if (frame != nullptr)
+            *frame = dropped;
+        else
+            publishDrops++;
+    }
+    trackSensor(rxMode, rx.id, rx.offset);
+    if (afc)
+        adjustReceiver();
+}
+
+/**
+ * @brief checksum errors are only counted if no decoder accepted the transmission
+ * Within a mode the decoders get the same frame, one that is accepted makes the checksum errors of
+ * the others false syncs. In sample capture other modes sync on the same transmission, a frame
+ * decoded in another mode within falseSyncWindow does the same. Until then the checksum error is
+ * kept as a suspect.
+ * 
+ * @param failed bit per decoder of rxMode whose checksum didn't match
+ * @param decoded a decoder of rxMode accepted the frame
+ */
+void Gw868::countChecksumErrors(const uint8_t rxMode, const uint16_t failed, const bool decoded, const uint32_t now) {
+    resolveSuspects(now);
+    const bool sampled = capture == GW868CAPTURE_SAMPLES;
+    bool accepted = decoded;
+
+    if (decoded) {
+        if (sampled) {
+            // frames of other modes failed before this one completed
+            for (uint8_t d=0; d<GW868DECODERS; d++) {
+                if ( ((suspects & (1<<d)) != 0) && ((modeDecoders[rxMode] & (1<<d)) == 0) ) {
+                    decoderStats[d].falseSyncs++;
+                    suspects &= ~(1<<d);
+                }
+            }
+            lastDecodedMode = rxMode;
+            lastDecoded = now;
+        }
+    }
+    else if ( sampled && (lastDecodedMode != NORXMODE) && (lastDecodedMode != rxMode) && (now - lastDecoded <= falseSyncWindow) )
+        accepted = true; // the transmission was decoded in another mode before this frame completed
+
+    for (uint8_t d=0; d<GW868DECODERS; d++) {
+        if ((failed & (1<<d)) == 0)
+            continue;
+        if (accepted)
+            decoderStats[d].falseSyncs++;
+        else if (sampled) {
+            if ((suspects & (1<<d)) != 0)
+                decoderStats[d].checksumErrors++; // previous frame of the decoder, nothing decoded since
+            suspects |= 1<<d;
+            suspectSince[d] = now;
         }
+        else
+            decoderStats[d].checksumErrors++;
+    }
+}
 
-        line += String(rssi) + F(" dBm");
-        ws.textAll(line);
+/**
+ * @brief suspects older than falseSyncWindow were checksum errors
+ */
+void Gw868::resolveSuspects(const uint32_t now) {
+    for (uint8_t d=0; (suspects != 0) && (d<GW868DECODERS); d++) {
+        if ( ((suspects & (1<<d)) != 0) && (now - suspectSince[d] > falseSyncWindow) ) {
+            decoderStats[d].checksumErrors++;
+            suspects &= ~(1<<d);
+        }
+    }
+}
 
-        switch (currentRxMode) {
-        case RXMODE_TX35:
-        case RXMODE_EMT7170:
-            if (EMT7170Decoder::decode(buf, currentRxLen, rssi))
-                break;
-            // no break here!
+/**
+ * @brief next free entry of the publish queue
+ * 
+ * @param replace true: if the queue is full, the latest frame that didn't decode is given up
+ * @return nullptr if the queue is full
+ */
+Gw868::PendingFrame *Gw868::queueFrame(const bool replace) {
+    if (pendingLen < PUBLISHQUEUE)
+        return &pendingFrames[(pendingHead + pendingLen++) % PUBLISHQUEUE];
+
+    for (uint8_t i=PUBLISHQUEUE; replace && (i > 0); i--) {
+        PendingFrame &frame = pendingFrames[(pendingHead + i - 1) % PUBLISHQUEUE];
+        if (frame.decoder == NORXMODE)
+            return &frame;
+    }
+    return nullptr;
+}
 
-        case RXMODE_TX29:
-            LaCrosseDecoder::decode(buf, currentRxLen, rssi);
-            break;
+/**
+ * @brief logs the oldest queued frame and publishes it if it decoded
+ * One frame per loop(), the receiver is served in between.
+ */
+void Gw868::publishPending() {
+    if (pendingLen == 0)
+        return;
+
+    const PendingFrame &frame = pendingFrames[pendingHead];
+    String line;
+    line = F("RFM payload: ");
+    
+    for (uint8_t i = 0; i < frame.len; i++) {
+        if (frame.raw[i] < 0x10)
+            line += '0';
+        line += String(frame.raw[i], HEX) + ' ';
+    }
 
-        case RXMODE_EC3K:
-            EC3KDecoder::decode(buf, currentRxLen, rssi);
-            break;
+    line += String(frame.rx.rssi) + F(" dBm, ");
+    line += String(frame.rx.offset) + F(" Hz");
+    ws.textAll(line);
+
+    if (frame.decoder != NORXMODE)
+        DECODERS[frame.decoder].publish(frame.data, frame.rx);
 
-        case RXMODE_BRESSER:
-            Bresser7in1Decoder::decode(buf, currentRxLen, rssi);
+    pendingHead = (pendingHead + 1) % PUBLISHQUEUE;
+    pendingLen--;
+}
+
+/**
+ * @brief groups the enabled decoders into receive modes by bitrate and sync word, a mode is
+ * numbered like the lowest of its decoders
+ */
+void Gw868::buildModes() {
+    falseSyncWindow = 0;
+    for (uint8_t d=0; d<GW868DECODERS; d++) {
+        modeDecoders[d] = 0;
+        if ((rxModes & (1<<d)) == 0)
+            continue;
+
+        const uint32_t airTime = (DECODERS[d].syncLen + DECODERS[d].frameLen) * 8000000UL / DECODERS[d].bitrate;
+        if (airTime > falseSyncWindow)
+            falseSyncWindow = airTime;
+
+        uint8_t m = 0;
+        while ( (m < d) && ((modeDecoders[m] == 0) || !sameRxMode(DECODERS[m], DECODERS[d])) )
+            m++;
+        modeDecoders[m] |= 1<<d;
+    }
+}
+
+/**
+ * @brief frame length of a mode, the longest of its decoders
+ */
+uint8_t Gw868::frameLen(const uint8_t rxMode) {
+    uint8_t len = 0;
+    for (uint8_t d=0; d<GW868DECODERS; d++)
+        if ( ((modeDecoders[rxMode] & (1<<d)) != 0) && (DECODERS[d].frameLen > len) )
+            len = DECODERS[d].frameLen;
+    return len;
+}
+
+/**
+ * @brief receives samples into the FIFO continuously, a demodulator channel per enabled mode
+ */
+void Gw868::startSampling() {
+    demod.clear();
+    for (uint8_t m=0; m<GW868DECODERS; m++) {
+        if (modeDecoders[m] == 0)
+            continue;
+        demod.addChannel(m, DECODERS[m].bitrate, DECODERS[m].sync, DECODERS[m].syncLen, frameLen(m));
+    }
+
+    radio->setSync(nullptr, 0);
+    radio->setBitrate(FSKSAMPLERATE);
+    radio->setFifoThreshold(SAMPLEFIFOTHRESH);
+    radio->startReceive(0);
+    lastFifoRead = micros();
+}
+
+/**
+ * @brief sets bitrate, sync word and frame length of a mode and restarts the receiver
+ */
+void Gw868::switchMode(const uint8_t rxMode) {
+    auto mode = &DECODERS[rxMode];
+    currentRxMode = rxMode;
+    radio->setBitrate(mode->bitrate);
+    radio->setSync(mode->sync, mode->syncLen);
+    currentRxLen = frameLen(rxMode);
+    if (afc)
+        adjustReceiver(); // drop transmitters not heard for a while
+    radio->startReceive(currentRxLen);
+}
+
+/**
+ * @brief mode of the transmitter whose next frame is expected soonest, if its receive window
+ * is open
+ * The window spans SCHEDGUARD around the expected time and widens with every period predicted
+ * ahead, as the error of the period estimate adds up.
+ * 
+ * @return NORXMODE if no known transmitter is due
+ */
+uint8_t Gw868::dueRxMode(const unsigned long now) {
+    uint8_t rxMode = NORXMODE;
+    long earliest = 0;
+    for (auto &sensor : sensors) {
+        if ( (sensor.rxMode == NORXMODE) || (sensor.period == 0) )
+            continue;
+
+        // first frame whose window has not closed yet
+        const uint32_t elapsed = now - sensor.lastSeen;
+        uint32_t k = 1;
+        if (elapsed > SCHEDGUARD)
+            k = (elapsed - SCHEDGUARD + sensor.period - 1) / sensor.period;
+        if (k == 0)
+            k = 1;
+        if (k > SCHEDMAXMISSES)
+            continue;
+
+        const long guard = SCHEDGUARD + (k - 1) * sensor.period / 64;
+        const long untilDue = (long) (k * sensor.period) - (long) elapsed;
+        if ( (untilDue > guard) || (untilDue < -guard) )
+            continue;
+        if ( (rxMode == NORXMODE) || (untilDue < earliest) ) {
+            rxMode = sensor.rxMode;
+            earliest = untilDue;
+        }
+    }
+    return rxMode;
+}
+
+/**
+ * @brief updates offset and period estimate of a transmitter
+ * An unknown transmitter takes a free slot or the one not heard for the longest time.
+ */
+void Gw868::trackSensor(const uint8_t rxMode, const uint32_t id, const int32_t offset) {
+    const unsigned long now = millis();
+    Sensor *slot = nullptr;
+    for (auto &sensor : sensors) {
+        if ( (sensor.rxMode == rxMode) && (sensor.id == id) ) {
+            slot = &sensor;
             break;
         }
+        if ( (slot == nullptr) || ((slot->rxMode != NORXMODE) &&
+                ((sensor.rxMode == NORXMODE) || ((long) (sensor.lastSeen - slot->lastSeen) < 0))) )
+            slot = &sensor;
+    }
+
+    if ( (slot->rxMode != rxMode) || (slot->id != id) ) {
+        slot->rxMode = rxMode;
+        slot->id = id;
+        slot->offset = offset;
+        slot->frames = 0;
+        slot->period = 0;
+        slot->firstSeen = now;
+    }
+    else {
+        slot->offset += (offset - slot->offset) / TRACKWEIGHT;
+        trackPeriod(*slot, now);
+    }
+    slot->frames++;
+    slot->lastSeen = now;
+}
 
-        rfm69->startReceive(currentRxLen);
+/**
+ * @brief learns the transmit period from the gap to the previous frame
+ * A gap of several periods means frames were missed, it refines the estimate by its share. A
+ * clearly shorter gap replaces the estimate, it was a multiple of the period. Gaps off the grid
+ * of the estimate discard it, the next gap starts over.
+ */
+void Gw868::trackPeriod(Sensor &sensor, const unsigned long now) {
+    const uint32_t gap = now - sensor.lastSeen;
+    if ( (gap < PERIODMIN) || (gap > PERIODMAX) )
+        return;
+
+    if ( (sensor.period == 0) || (gap < sensor.period * 3 / 4) ) {
+        sensor.period = gap;
+        return;
     }
-}
\ No newline at end of file
+
+    const uint32_t n = (gap + sensor.period / 2) / sensor.period;
+    const int32_t error = (int32_t) (gap - n * sensor.period);
+    if ((uint32_t) abs(error) > sensor.period / 8)
+        sensor.period = 0;
+    else
+        sensor.period += error / (int32_t) n / TRACKWEIGHT;
+}
+
+/**
+ * @brief centers the carrier between the offsets of the transmitters heard recently and narrows
+ * the channel filter to rxBwMin plus half their spread
+ * Without known offsets the receiver is back at GW868FREQ with GW868RXBW.
+ */
+void Gw868::adjustReceiver() {
+    int32_t lo = INT32_MAX;
+    int32_t hi = INT32_MIN;
+    const unsigned long now = millis();
+    for (auto &sensor : sensors) {
+        if ( (sensor.rxMode == NORXMODE) || (sensor.frames < TRACKMINFRAMES) || (now - sensor.lastSeen > TRACKTIMEOUT) )
+            continue;
+        if (sensor.offset < lo)
+            lo = sensor.offset;
+        if (sensor.offset > hi)
+            hi = sensor.offset;
+    }
+
+    int32_t offset = 0;
+    uint32_t bw = GW868RXBW;
+    if (lo <= hi) {
+        offset = (lo + hi) / 2 / OFFSETSTEP * OFFSETSTEP;
+        bw = rxBwMin + (uint32_t) (hi - lo) / 2;
+        if (bw > GW868RXBW)
+            bw = GW868RXBW;
+    }
+
+    if (offset != carrierOffset) {
+        carrierOffset = offset;
+        radio->setFreq(GW868FREQ + offset);
+    }
+    if (bw != rxBw) {
+        rxBw = bw;
+        radio->setRxBandwidth(bw);
+    }
+}
+
+void Gw868::getStatus(JsonObject &obj) {
+    resolveSuspects(micros());
+    obj[F("capture")] = capture;
+    if (capture == GW868CAPTURE_SAMPLES) {
+        JsonArray jChannels = obj[F("channels")].to<JsonArray>();
+        for (uint8_t c=0; c<demod.getNumChannels(); c++) {
+            JsonObject jChannel = jChannels.add<JsonObject>();
+            jChannel[F("rxMode")] = demod.getTag(c);
+            jChannel[F("syncs")] = demod.getSyncs(c);
+        }
+        obj[F("fifoReadGapMax")] = fifoReadGapMax;
+    }
+    obj[F("publishDrops")] = publishDrops;
+    obj[F("afc")] = afc;
+    obj[F("carrierOffset")] = carrierOffset;
+    obj[F("rxBw")] = rxBw;
+    obj[F("schedule")] = schedule;
+    obj[F("scheduledSwitches")] = scheduledSwitches;
+
+    JsonArray jDecoders = obj[F("decoders")].to<JsonArray>();
+    for (uint8_t m=0; m<GW868DECODERS; m++) {
+        for (uint8_t d=0; d<GW868DECODERS; d++) {
+            if ((modeDecoders[m] & (1<<d)) == 0)
+                continue;
+            const DecoderStats &stats = decoderStats[d];
+            JsonObject jDecoder = jDecoders.add<JsonObject>();
+            jDecoder[F("name")] = FPSTR(DECODERS[d].name);
+            jDecoder[F("rxMode")] = m;
+            jDecoder[F("frames")] = stats.frames;
+            jDecoder[F("checksumErrors")] = stats.checksumErrors;
+            jDecoder[F("falseSyncs")] = stats.falseSyncs;
+            jDecoder[F("decoded")] = stats.decoded;
+            jDecoder[F("cpuTime")] = stats.cpuTime;
+        }
+    }
+
+    JsonArray jSensors = obj[F("sensors")].to<JsonArray>();
+    const unsigned long now = millis();
+    for (auto &sensor : sensors) {
+        if (sensor.rxMode == NORXMODE)
+            continue;
+        JsonObject jSensor = jSensors.add<JsonObject>();
+        jSensor[F("rxMode")] = sensor.rxMode;
+        jSensor[F("id")] = String(sensor.id, HEX);
+        jSensor[F("offset")] = sensor.offset;
+        jSensor[F("frames")] = sensor.frames;
+        jSensor[F("age")] = (now - sensor.lastSeen) / 1000;
+        if (sensor.period != 0) {
+            // frames received of those sent since the transmitter was first heard
+            const uint32_t sent = (now - sensor.firstSeen) / sensor.period + 1;
+            jSensor[F("period")] = sensor.period;
+            jSensor[F("captureRate")] = (sensor.frames >= sent) ? 100 : sensor.frames * 100 / sent;
+        }
+    }
+}
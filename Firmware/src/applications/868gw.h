@@ -1,15 +1,122 @@
 #pragma once
 
 #include "../radioapplication.h"
+#include "fskdemod.h"
+
+const uint32_t GW868FREQ = 868300000UL;
+const uint32_t GW868RXBW = 250000; // Hz, channel filter without known drift
+const uint8_t SENSORSLOTS = 16; // transmitters with tracked frequency offset and period
+const uint8_t GW868DECODERS = 6; // entries of the decoder registry, bits of the rxmodes setting
+const uint8_t PUBLISHQUEUE = 4; // frames waiting to be logged and published
+
+/**
+ * @brief how the enabled receive modes are received
+ */
+enum Gw868Capture : uint8_t {
+    GW868CAPTURE_PACKET = 0, // packet engine, modes are switched in turn or as scheduled
+    GW868CAPTURE_SAMPLES = 1 // FIFO holds samples of FSKSAMPLERATE, all modes are demodulated in software
+};
+
+/**
+ * @brief frame as handed to the decoders, they set the transmitter ID of valid frames
+ */
+struct RxFrame {
+    int8_t rssi;
+    int32_t offset; // Hz, carrier offset of the transmitter from GW868FREQ
+    uint32_t id;
+};
+
+/**
+ * @brief outcome of a decoder, counted in the decoder statistics
+ */
+enum Gw868DecodeResult : uint8_t {
+    GW868DECODE_OK,
+    GW868DECODE_INVALID, // too short or not framed like the protocol
+    GW868DECODE_CHECKSUM // framed, but the checksum doesn't match
+};
 
 class Gw868: public RadioApplication {
 private:
+    /**
+     * @brief frames handled by a decoder of the registry
+     */
+    struct DecoderStats {
+        uint32_t frames; // handed to the decoder
+        uint32_t checksumErrors; // no decoder accepted the transmission
+        uint32_t falseSyncs; // checksum didn't match, but another decoder accepted the transmission
+        uint32_t decoded;
+        uint32_t cpuTime; // µs spent in the decoder, publishing is not included
+    };
+
+    /**
+     * @brief frame decoded in handleFrame(), logged and published by publishPending()
+     */
+    struct PendingFrame {
+        uint8_t rxMode;
+        uint8_t decoder; // index in the registry, NORXMODE: didn't decode
+        uint8_t len;
+        RxFrame rx;
+        uint8_t raw[FSKFRAMESIZE]; // as received
+        uint8_t data[FSKFRAMESIZE]; // as left by the decoder
+    };
+
+    /**
+     * @brief running estimate of a transmitter's carrier offset and transmit period
+     */
+    struct Sensor {
+        uint8_t rxMode; // 0xFF: unused slot
+        uint32_t id;
+        int32_t offset; // Hz, exponential moving average over the frames
+        uint32_t frames;
+        uint32_t period; // ms, 0: not known yet
+        unsigned long firstSeen; // millis()
+        unsigned long lastSeen; // millis()
+    };
+
+    Gw868Capture capture;
+    FskDemod demod;
     uint8_t currentRxMode;
-    uint16_t rxModes; // bitmask
+    uint8_t discoveryRxMode; // round robin through rxModes while no transmitter is due
+    uint16_t rxModes; // bitmask of enabled decoders
+    uint16_t modeDecoders[GW868DECODERS]; // bitmask of the decoders received in the mode of the lowest of them, 0: no receive mode
     uint8_t currentRxLen;
     unsigned long nextSwitch;
     uint32_t interval;
+    bool afc; // follow the tracked offsets with carrier and channel filter
+    bool schedule; // switch to the mode of transmitters when they are due
+    bool scheduled; // currentRxMode was chosen for a due transmitter
+    uint32_t scheduledSwitches;
+    uint32_t rxBwMin; // Hz, channel filter with all offsets compensated
+    int32_t carrierOffset; // Hz, applied on top of GW868FREQ
+    uint32_t rxBw; // Hz, requested channel filter
+    Sensor sensors[SENSORSLOTS];
+    DecoderStats decoderStats[GW868DECODERS];
+    uint16_t suspects; // bit per decoder, checksum error in sample capture that may still turn out a false sync
+    uint32_t suspectSince[GW868DECODERS]; // micros() of the suspect frame
+    uint8_t lastDecodedMode;
+    uint32_t lastDecoded; // micros()
+    uint32_t falseSyncWindow; // µs, longest air time of a frame of the enabled modes
+    PendingFrame pendingFrames[PUBLISHQUEUE];
+    uint8_t pendingHead;
+    uint8_t pendingLen;
+    uint32_t publishDrops; // decoded frames not published, the queue was full
+    uint32_t lastFifoRead; // micros()
+    uint32_t fifoReadGapMax; // µs, longest time between two FIFO reads in sample capture
+    void buildModes();
+    void startSampling();
+    void switchMode(const uint8_t rxMode);
+    uint8_t frameLen(const uint8_t rxMode);
+    void handleFrame(const uint8_t rxMode, uint8_t *buf, const uint8_t len);
+    PendingFrame *queueFrame(const bool replace);
+    void publishPending();
+    void countChecksumErrors(const uint8_t rxMode, const uint16_t failed, const bool decoded, const uint32_t now);
+    void resolveSuspects(const uint32_t now);
+    uint8_t dueRxMode(const unsigned long now);
+    void trackSensor(const uint8_t rxMode, const uint32_t id, const int32_t offset);
+    static void trackPeriod(Sensor &sensor, const unsigned long now);
+    void adjustReceiver();
 public:
-    Gw868(const JsonObject &conf);
+    Gw868(RfmBase *radio, const JsonObject &conf);
     void loop();
-};
\ No newline at end of file
+    void getStatus(JsonObject &obj);
+};
@@ -0,0 +1,199 @@
+#include "checksum.h"
+
+#ifdef CHECKSUM_NIBBLETABLES
+static const uint8_t CRC8TAB[] PROGMEM = {
+    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97, 0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E
+};
+
+static const uint16_t CRCCCITTTAB[] PROGMEM = {
+    0x0000, 0x1081, 0x2102, 0x3183, 0x4204, 0x5285, 0x6306, 0x7387,
+    0x8408, 0x9489, 0xA50A, 0xB58B, 0xC60C, 0xD68D, 0xE70E, 0xF78F
+};
+
+// feedback of the low nibble when the LFSR is advanced by 4 bits
+static const uint16_t LFSRSHIFTTAB[] PROGMEM = {
+    0x0000, 0x1102, 0x2204, 0x3306, 0x4408, 0x550A, 0x660C, 0x770E,
+    0x8810, 0x9912, 0xAA14, 0xBB16, 0xCC18, 0xDD1A, 0xEE1C, 0xFF1E
+};
+
+// XOR of the keys of the bits set in the high nibble, then in the low nibble
+static const uint16_t BRESSERKEYTAB[] PROGMEM = {
+    0x0000, 0xBD46, 0x6AAD, 0xD7EB, 0xD55A, 0x681C, 0xBFF7, 0x02B1,
+    0xBA95, 0x07D3, 0xD038, 0x6D7E, 0x6FCF, 0xD289, 0x0562, 0xB824,
+    0x0000, 0x6DD8, 0xDBB0, 0xB668, 0xA741, 0xCA99, 0x7CF1, 0x1129,
+    0x5EA3, 0x337B, 0x8513, 0xE8CB, 0xF9E2, 0x943A, 0x2252, 0x4F8A
+};
+
+uint8_t crc8(const uint8_t *buf, const size_t len, uint8_t crc) {
+    for (size_t i=0; i<len; i++) {
+        crc ^= buf[i];
+        crc = (crc << 4) ^ pgm_read_byte(&CRC8TAB[crc >> 4]);
+        crc = (crc << 4) ^ pgm_read_byte(&CRC8TAB[crc >> 4]);
+    }
+    return crc;
+}
+
+uint16_t crcCcitt(const uint8_t *buf, const size_t len, uint16_t crc) {
+    for (size_t i=0; i<len; i++) {
+        crc ^= buf[i];
+        crc = (crc >> 4) ^ pgm_read_word(&CRCCCITTTAB[crc & 0x0F]);
+        crc = (crc >> 4) ^ pgm_read_word(&CRCCCITTTAB[crc & 0x0F]);
+    }
+    return crc;
+}
+
+uint16_t bresserDigest(const uint8_t *buf, const size_t len) {
+    uint16_t digest = 0;
+    for (size_t i=len; i-- > 0; ) {
+        digest = (digest >> 4) ^ pgm_read_word(&LFSRSHIFTTAB[digest & 0x0F]);
+        digest = (digest >> 4) ^ pgm_read_word(&LFSRSHIFTTAB[digest & 0x0F]);
+        digest ^= pgm_read_word(&BRESSERKEYTAB[buf[i] >> 4]) ^ pgm_read_word(&BRESSERKEYTAB[16 + (buf[i] & 0x0F)]);
+    }
+    return digest;
+}
+#else
+static const uint8_t CRC8TAB[] PROGMEM = {
+    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97, 0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+    0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4, 0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+    0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11, 0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+    0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52, 0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+    0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA, 0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+    0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9, 0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+    0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C, 0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+    0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F, 0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+    0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED, 0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+    0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE, 0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+    0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B, 0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+    0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28, 0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+    0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0, 0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+    0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93, 0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+    0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56, 0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+    0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15, 0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC
+};
+
+static const uint16_t CRCCCITTTAB[] PROGMEM = {
+    0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
+    0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
+    0x1081, 0x0108, 0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E,
+    0x9CC9, 0x8D40, 0xBFDB, 0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876,
+    0x2102, 0x308B, 0x0210, 0x1399, 0x6726, 0x76AF, 0x4434, 0x55BD,
+    0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E, 0xFAE7, 0xC87C, 0xD9F5,
+    0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E, 0x54B5, 0x453C,
+    0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD, 0xC974,
+    0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
+    0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3,
+    0x5285, 0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A,
+    0xDECD, 0xCF44, 0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72,
+    0x6306, 0x728F, 0x4014, 0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9,
+    0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5, 0xA96A, 0xB8E3, 0x8A78, 0x9BF1,
+    0x7387, 0x620E, 0x5095, 0x411C, 0x35A3, 0x242A, 0x16B1, 0x0738,
+    0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862, 0x9AF9, 0x8B70,
+    0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E, 0xF0B7,
+    0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
+    0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036,
+    0x18C1, 0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E,
+    0xA50A, 0xB483, 0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5,
+    0x2942, 0x38CB, 0x0A50, 0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD,
+    0xB58B, 0xA402, 0x9699, 0x8710, 0xF3AF, 0xE226, 0xD0BD, 0xC134,
+    0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7, 0x6E6E, 0x5CF5, 0x4D7C,
+    0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1, 0xA33A, 0xB2B3,
+    0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72, 0x3EFB,
+    0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
+    0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A,
+    0xE70E, 0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1,
+    0x6B46, 0x7ACF, 0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9,
+    0xF78F, 0xE606, 0xD49D, 0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330,
+    0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78
+};
+
+// feedback of the low byte when the LFSR is advanced by 8 bits
+static const uint16_t LFSRSHIFTTAB[] PROGMEM = {
+    0x0000, 0x2314, 0x4628, 0x653C, 0x8C50, 0xAF44, 0xCA78, 0xE96C,
+    0x0881, 0x2B95, 0x4EA9, 0x6DBD, 0x84D1, 0xA7C5, 0xC2F9, 0xE1ED,
+    0x1102, 0x3216, 0x572A, 0x743E, 0x9D52, 0xBE46, 0xDB7A, 0xF86E,
+    0x1983, 0x3A97, 0x5FAB, 0x7CBF, 0x95D3, 0xB6C7, 0xD3FB, 0xF0EF,
+    0x2204, 0x0110, 0x642C, 0x4738, 0xAE54, 0x8D40, 0xE87C, 0xCB68,
+    0x2A85, 0x0991, 0x6CAD, 0x4FB9, 0xA6D5, 0x85C1, 0xE0FD, 0xC3E9,
+    0x3306, 0x1012, 0x752E, 0x563A, 0xBF56, 0x9C42, 0xF97E, 0xDA6A,
+    0x3B87, 0x1893, 0x7DAF, 0x5EBB, 0xB7D7, 0x94C3, 0xF1FF, 0xD2EB,
+    0x4408, 0x671C, 0x0220, 0x2134, 0xC858, 0xEB4C, 0x8E70, 0xAD64,
+    0x4C89, 0x6F9D, 0x0AA1, 0x29B5, 0xC0D9, 0xE3CD, 0x86F1, 0xA5E5,
+    0x550A, 0x761E, 0x1322, 0x3036, 0xD95A, 0xFA4E, 0x9F72, 0xBC66,
+    0x5D8B, 0x7E9F, 0x1BA3, 0x38B7, 0xD1DB, 0xF2CF, 0x97F3, 0xB4E7,
+    0x660C, 0x4518, 0x2024, 0x0330, 0xEA5C, 0xC948, 0xAC74, 0x8F60,
+    0x6E8D, 0x4D99, 0x28A5, 0x0BB1, 0xE2DD, 0xC1C9, 0xA4F5, 0x87E1,
+    0x770E, 0x541A, 0x3126, 0x1232, 0xFB5E, 0xD84A, 0xBD76, 0x9E62,
+    0x7F8F, 0x5C9B, 0x39A7, 0x1AB3, 0xF3DF, 0xD0CB, 0xB5F7, 0x96E3,
+    0x8810, 0xAB04, 0xCE38, 0xED2C, 0x0440, 0x2754, 0x4268, 0x617C,
+    0x8091, 0xA385, 0xC6B9, 0xE5AD, 0x0CC1, 0x2FD5, 0x4AE9, 0x69FD,
+    0x9912, 0xBA06, 0xDF3A, 0xFC2E, 0x1542, 0x3656, 0x536A, 0x707E,
+    0x9193, 0xB287, 0xD7BB, 0xF4AF, 0x1DC3, 0x3ED7, 0x5BEB, 0x78FF,
+    0xAA14, 0x8900, 0xEC3C, 0xCF28, 0x2644, 0x0550, 0x606C, 0x4378,
+    0xA295, 0x8181, 0xE4BD, 0xC7A9, 0x2EC5, 0x0DD1, 0x68ED, 0x4BF9,
+    0xBB16, 0x9802, 0xFD3E, 0xDE2A, 0x3746, 0x1452, 0x716E, 0x527A,
+    0xB397, 0x9083, 0xF5BF, 0xD6AB, 0x3FC7, 0x1CD3, 0x79EF, 0x5AFB,
+    0xCC18, 0xEF0C, 0x8A30, 0xA924, 0x4048, 0x635C, 0x0660, 0x2574,
+    0xC499, 0xE78D, 0x82B1, 0xA1A5, 0x48C9, 0x6BDD, 0x0EE1, 0x2DF5,
+    0xDD1A, 0xFE0E, 0x9B32, 0xB826, 0x514A, 0x725E, 0x1762, 0x3476,
+    0xD59B, 0xF68F, 0x93B3, 0xB0A7, 0x59CB, 0x7ADF, 0x1FE3, 0x3CF7,
+    0xEE1C, 0xCD08, 0xA834, 0x8B20, 0x624C, 0x4158, 0x2464, 0x0770,
+    0xE69D, 0xC589, 0xA0B5, 0x83A1, 0x6ACD, 0x49D9, 0x2CE5, 0x0FF1,
+    0xFF1E, 0xDC0A, 0xB936, 0x9A22, 0x734E, 0x505A, 0x3566, 0x1672,
+    0xF79F, 0xD48B, 0xB1B7, 0x92A3, 0x7BCF, 0x58DB, 0x3DE7, 0x1EF3
+};
+
+// XOR of the keys of the bits set in a byte
+static const uint16_t BRESSERKEYTAB[] PROGMEM = {
+    0x0000, 0x6DD8, 0xDBB0, 0xB668, 0xA741, 0xCA99, 0x7CF1, 0x1129,
+    0x5EA3, 0x337B, 0x8513, 0xE8CB, 0xF9E2, 0x943A, 0x2252, 0x4F8A,
+    0xBD46, 0xD09E, 0x66F6, 0x0B2E, 0x1A07, 0x77DF, 0xC1B7, 0xAC6F,
+    0xE3E5, 0x8E3D, 0x3855, 0x558D, 0x44A4, 0x297C, 0x9F14, 0xF2CC,
+    0x6AAD, 0x0775, 0xB11D, 0xDCC5, 0xCDEC, 0xA034, 0x165C, 0x7B84,
+    0x340E, 0x59D6, 0xEFBE, 0x8266, 0x934F, 0xFE97, 0x48FF, 0x2527,
+    0xD7EB, 0xBA33, 0x0C5B, 0x6183, 0x70AA, 0x1D72, 0xAB1A, 0xC6C2,
+    0x8948, 0xE490, 0x52F8, 0x3F20, 0x2E09, 0x43D1, 0xF5B9, 0x9861,
+    0xD55A, 0xB882, 0x0EEA, 0x6332, 0x721B, 0x1FC3, 0xA9AB, 0xC473,
+    0x8BF9, 0xE621, 0x5049, 0x3D91, 0x2CB8, 0x4160, 0xF708, 0x9AD0,
+    0x681C, 0x05C4, 0xB3AC, 0xDE74, 0xCF5D, 0xA285, 0x14ED, 0x7935,
+    0x36BF, 0x5B67, 0xED0F, 0x80D7, 0x91FE, 0xFC26, 0x4A4E, 0x2796,
+    0xBFF7, 0xD22F, 0x6447, 0x099F, 0x18B6, 0x756E, 0xC306, 0xAEDE,
+    0xE154, 0x8C8C, 0x3AE4, 0x573C, 0x4615, 0x2BCD, 0x9DA5, 0xF07D,
+    0x02B1, 0x6F69, 0xD901, 0xB4D9, 0xA5F0, 0xC828, 0x7E40, 0x1398,
+    0x5C12, 0x31CA, 0x87A2, 0xEA7A, 0xFB53, 0x968B, 0x20E3, 0x4D3B,
+    0xBA95, 0xD74D, 0x6125, 0x0CFD, 0x1DD4, 0x700C, 0xC664, 0xABBC,
+    0xE436, 0x89EE, 0x3F86, 0x525E, 0x4377, 0x2EAF, 0x98C7, 0xF51F,
+    0x07D3, 0x6A0B, 0xDC63, 0xB1BB, 0xA092, 0xCD4A, 0x7B22, 0x16FA,
+    0x5970, 0x34A8, 0x82C0, 0xEF18, 0xFE31, 0x93E9, 0x2581, 0x4859,
+    0xD038, 0xBDE0, 0x0B88, 0x6650, 0x7779, 0x1AA1, 0xACC9, 0xC111,
+    0x8E9B, 0xE343, 0x552B, 0x38F3, 0x29DA, 0x4402, 0xF26A, 0x9FB2,
+    0x6D7E, 0x00A6, 0xB6CE, 0xDB16, 0xCA3F, 0xA7E7, 0x118F, 0x7C57,
+    0x33DD, 0x5E05, 0xE86D, 0x85B5, 0x949C, 0xF944, 0x4F2C, 0x22F4,
+    0x6FCF, 0x0217, 0xB47F, 0xD9A7, 0xC88E, 0xA556, 0x133E, 0x7EE6,
+    0x316C, 0x5CB4, 0xEADC, 0x8704, 0x962D, 0xFBF5, 0x4D9D, 0x2045,
+    0xD289, 0xBF51, 0x0939, 0x64E1, 0x75C8, 0x1810, 0xAE78, 0xC3A0,
+    0x8C2A, 0xE1F2, 0x579A, 0x3A42, 0x2B6B, 0x46B3, 0xF0DB, 0x9D03,
+    0x0562, 0x68BA, 0xDED2, 0xB30A, 0xA223, 0xCFFB, 0x7993, 0x144B,
+    0x5BC1, 0x3619, 0x8071, 0xEDA9, 0xFC80, 0x9158, 0x2730, 0x4AE8,
+    0xB824, 0xD5FC, 0x6394, 0x0E4C, 0x1F65, 0x72BD, 0xC4D5, 0xA90D,
+    0xE687, 0x8B5F, 0x3D37, 0x50EF, 0x41C6, 0x2C1E, 0x9A76, 0xF7AE
+};
+
+uint8_t crc8(const uint8_t *buf, const size_t len, uint8_t crc) {
+    for (size_t i=0; i<len; i++)
+        crc = pgm_read_byte(&CRC8TAB[crc ^ buf[i]]);
+    return crc;
+}
+
+uint16_t crcCcitt(const uint8_t *buf, const size_t len, uint16_t crc) {
+    for (size_t i=0; i<len; i++)
+        crc = (crc >> 8) ^ pgm_read_word(&CRCCCITTTAB[(crc ^ buf[i]) & 0xFF]);
+    return crc;
+}
+
+uint16_t bresserDigest(const uint8_t *buf, const size_t len) {
+    uint16_t digest = 0;
+    for (size_t i=len; i-- > 0; )
+        digest = (digest >> 8) ^ pgm_read_word(&LFSRSHIFTTAB[digest & 0xFF]) ^ pgm_read_word(&BRESSERKEYTAB[buf[i]]);
+    return digest;
+}
+#endif
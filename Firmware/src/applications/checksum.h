@@ -0,0 +1,29 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief checksums of the 868 MHz sensor protocols, table driven
+ * The tables are in flash, 256 entries per algorithm and byte. Builds short of flash define
+ * CHECKSUM_NIBBLETABLES for tables of 16 entries, processed a nibble at a time.
+ */
+
+/**
+ * @brief CRC-8, polynomial 0x31, MSB first, no final XOR (LaCrosse)
+ * A frame followed by its CRC results in 0.
+ */
+uint8_t crc8(const uint8_t *buf, const size_t len, uint8_t crc = 0);
+
+/**
+ * @brief CRC-CCITT, polynomial 0x1021 LSB first, no final XOR (EC3K), like avr-libc's
+ * _crc_ccitt_update()
+ * A frame followed by its CRC results in 0xF0B8 with the initial value 0xFFFF.
+ */
+uint16_t crcCcitt(const uint8_t *buf, const size_t len, uint16_t crc = 0xFFFF);
+
+/**
+ * @brief 16 bit LFSR digest of Bresser weather stations, generator 0x8810, key 0xBA95
+ * Every set bit of the message XORs the key into the digest, the key is shifted through the LFSR
+ * per bit. The digest is linear, so it is calculated from the last byte to the first, with the
+ * key tables for a byte and the LFSR advanced by 8 bits per table lookup.
+ */
+uint16_t bresserDigest(const uint8_t *buf, const size_t len);
@@ -0,0 +1,66 @@
+#include "ec3kframe.h"
+
+const uint32_t EC3KSCRAMBLERINIT = 0xF185D3AC; // input bits before the frame, the newest in bit 0
+
+static uint8_t reverseBits(uint8_t b) {
+    b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+    b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+    b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+    return b;
+}
+
+/**
+ * The descrambler is self-synchronizing. Every output bit is the inverted XOR of its input bit
+ * and the input bits 1, 12, 13, 17 and 18 bits before (LFSR taps 0x31801), so a whole byte is
+ * descrambled with shifted copies of the input history.
+ * HDLC sends the payload LSB first and inserts a 0 after five 1s. A byte is unstuffed as a whole
+ * if it does not complete a run of five 1s, otherwise bit by bit.
+ */
+int ec3kUnframe(uint8_t *buf, const size_t len) {
+    uint32_t history = EC3KSCRAMBLERINIT;
+    uint8_t ones = 0; // consecutive 1s at the end of the descrambled bits
+    uint32_t out = 0; // unstuffed bits not written yet, the oldest in bit 0
+    uint8_t outBits = 0;
+    uint8_t *po = &buf[1];
+
+    for (size_t i = 0; i < len; i++) {
+        history = history << 8 | buf[i];
+        const uint8_t data = ~(history ^ history >> 1 ^ history >> 12 ^ history >> 13 ^ history >> 17 ^ history >> 18);
+        if (i == 0) {
+            if (data != 0x7E)
+                return -1; // no HDLC frame!
+            continue;
+        }
+
+        const uint32_t run = ((1UL << (ones < 5 ? ones : 5)) - 1) << 8 | data;
+        if ((run & run >> 1 & run >> 2 & run >> 3 & run >> 4) == 0) {
+            out |= (uint32_t) reverseBits(data) << outBits;
+            outBits += 8;
+            ones = __builtin_ctz(~data); // data is not 0xFF here
+        }
+        else {
+            for (int8_t b = 7; b >= 0; b--) {
+                const uint8_t bit = (data >> b) & 1;
+                if ( (ones >= 5) && (bit == 0) ) {
+                    if (ones == 6) { // closing flag
+                        if (outBits >= 8)
+                            *po++ = out; // completed by the bits before the flag
+                        return po - &buf[1];
+                    }
+                    ones = 0; // stuffed bit
+                    continue;
+                }
+                ones = bit ? ones + 1 : 0;
+                out |= (uint32_t) bit << outBits;
+                outBits++;
+            }
+        }
+
+        while (outBits >= 8) {
+            *po++ = out;
+            out >>= 8;
+            outBits -= 8;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief descrambles a received EC3K frame and unstuffs its HDLC payload in one pass
+ * The opening flag has to be the first byte, the payload is written to buf + 1 in place. Bytes
+ * behind the closing flag are left untouched.
+ *
+ * @return payload bytes before the closing flag, -1 without opening or closing flag
+ */
+int ec3kUnframe(uint8_t *buf, const size_t len);
@@ -1,9 +1,10 @@
 #include "fs20.h"
 
-FS20::FS20(const JsonObject &conf) {
-    new FS20Codec;
+FS20::FS20(RfmBase *radio, const JsonObject &conf):
+        RcPulseTransceiver(radio) {
+    RcCodec::begin(RCCODECS_FS20);
 }
 
 FS20::~FS20() {
-    RcCodec::freeCodecs();
+    RcCodec::end();
 }
\ No newline at end of file
@@ -5,6 +5,6 @@
 class FS20: public RcPulseTransceiver {
 private:
 public:
-    FS20(const JsonObject &conf);
+    FS20(RfmBase *radio, const JsonObject &conf);
     ~FS20();
 };
\ No newline at end of file
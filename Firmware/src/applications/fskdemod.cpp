@@ -0,0 +1,122 @@
+#include "fskdemod.h"
+
+const uint8_t MINSAMPLESPERBIT = 3; // clock recovery needs the edges resolved within a bit
+
+FskDemod::FskDemod() {
+    clear();
+}
+
+void FskDemod::clear() {
+    numChannels = 0;
+    level = false;
+}
+
+/**
+ * @brief adds a channel for a bitrate and sync word, frames of frameLen bytes are collected
+ * Sync words of more than 4 bytes are matched on their last 4 bytes.
+ *
+ * @return false if all channels are in use or the bitrate is too high for FSKSAMPLERATE
+ */
+bool FskDemod::addChannel(const uint8_t tag, const uint16_t bitrate, const uint8_t *sync, const uint8_t syncLen, const uint8_t frameLen) {
+    if ( (numChannels >= FSKCHANNELS) || (frameLen > FSKFRAMESIZE) || (syncLen == 0) ||
+            ((uint32_t) bitrate * MINSAMPLESPERBIT > FSKSAMPLERATE) )
+        return false;
+
+    Channel &ch = channels[numChannels++];
+    ch.tag = tag;
+    ch.state = CH_HUNT;
+    ch.phaseStep = (((uint32_t) bitrate << 16) + FSKSAMPLERATE / 2) / FSKSAMPLERATE;
+    ch.phase = 0;
+    ch.shift = 0;
+    ch.syncWord = 0;
+    for (uint8_t i = (syncLen > 4) ? (syncLen - 4) : 0; i < syncLen; i++)
+        ch.syncWord = ch.syncWord << 8 | sync[i];
+    ch.syncMask = (syncLen >= 4) ? 0xFFFFFFFFUL : ((1UL << (syncLen * 8)) - 1);
+    ch.frameLen = frameLen;
+    ch.syncs = 0;
+    return true;
+}
+
+/**
+ * @brief feeds samples as read from the FIFO, one bit per sample, MSB first
+ */
+void FskDemod::process(const uint8_t *samples, const uint8_t len) {
+    for (uint8_t i=0; i<len; i++) {
+        // set bits mark samples differing from the current level, leading zeros are the samples until next edge
+        uint32_t edges = (uint32_t) (uint8_t) (level ? ~samples[i] : samples[i]) << 24;
+        uint8_t remaining = 8;
+
+        while (edges != 0) {
+            const uint8_t n = __builtin_clz(edges);
+            run(n, true);
+            level = !level;
+
+            // remaining samples relative to the new level, the one of the edge starts the next run
+            remaining -= n;
+            edges = (~edges << n) & (uint32_t) (0xFFFFFFFFUL << (32 - remaining));
+        }
+        run(remaining, false);
+    }
+}
+
+/**
+ * @brief advances all channels by a run of samples at the current level
+ *
+ * @param edge the level changes after the run
+ */
+void FskDemod::run(const uint8_t samples, const bool edge) {
+    for (uint8_t c=0; c<numChannels; c++) {
+        Channel &ch = channels[c];
+        ch.phase += samples * ch.phaseStep;
+        for (uint8_t n = ch.phase >> 16; n > 0; n--)
+            slice(ch, level);
+        ch.phase &= 0xFFFF;
+
+        // edges are expected half way between the slicing points, the clock is pulled half way towards them
+        if (edge)
+            ch.phase = (ch.phase + 0x8000) / 2;
+    }
+}
+
+void FskDemod::slice(Channel &ch, const bool bit) {
+    ch.shift = ch.shift << 1 | bit;
+    switch (ch.state) {
+    case CH_HUNT:
+        if ((ch.shift & ch.syncMask) == ch.syncWord) {
+            ch.state = CH_DATA;
+            ch.pos = 0;
+            ch.bits = 0;
+            ch.syncs++;
+        }
+        break;
+
+    case CH_DATA:
+        if (++ch.bits == 8) {
+            ch.frame[ch.pos++] = ch.shift;
+            ch.bits = 0;
+            if (ch.pos == ch.frameLen)
+                ch.state = CH_READY;
+        }
+        break;
+
+    default: // frame not released yet
+        break;
+    }
+}
+
+/**
+ * @return channel holding a complete frame, -1 if there is none
+ */
+int8_t FskDemod::nextFrame() {
+    for (uint8_t c=0; c<numChannels; c++)
+        if (channels[c].state == CH_READY)
+            return c;
+    return -1;
+}
+
+/**
+ * @brief frame is processed, the channel hunts for the next sync word
+ */
+void FskDemod::releaseFrame(const uint8_t ch) {
+    channels[ch].state = CH_HUNT;
+}
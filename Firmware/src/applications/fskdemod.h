@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+
+const uint16_t FSKSAMPLERATE = 64000; // samples/s of the demodulated data, 32 MHz / 500
+const uint8_t FSKCHANNELS = 6;
+const uint8_t FSKFRAMESIZE = 60;
+
+/**
+ * @brief software clock recovery, sync word search and bit slicing for several bitrates on one
+ * stream of FSK samples
+ * The receiver samples the demodulated data at FSKSAMPLERATE into the FIFO, MSB first. Each
+ * channel follows the bit clock of its bitrate with a phase accumulator, which is pulled towards
+ * the edges of the data. Bits are sliced in the middle between the expected edges. A channel
+ * hunts for its sync word, collects a frame of fixed length behind it and holds the frame until
+ * it is released.
+ * The samples are processed in runs between edges, so the cost is per edge and bit, not per
+ * sample.
+ */
+class FskDemod {
+private:
+    enum ChannelState: uint8_t {
+        CH_HUNT,
+        CH_DATA,
+        CH_READY
+    };
+
+    struct Channel {
+        uint8_t tag; // of the owner, e.g. its receive mode
+        ChannelState state;
+        uint32_t phaseStep; // per sample, 1 << 16 per bit
+        uint32_t phase; // lower 16 bits: position in the bit, 0: middle of the bit
+        uint32_t shift; // last sliced bits, LSB is the newest
+        uint32_t syncWord;
+        uint32_t syncMask;
+        uint8_t frameLen;
+        uint8_t pos; // bytes of the frame collected
+        uint8_t bits; // bits of the next byte collected
+        uint32_t syncs;
+        uint8_t frame[FSKFRAMESIZE];
+    };
+
+    Channel channels[FSKCHANNELS];
+    uint8_t numChannels;
+    bool level; // of the last sample
+    void run(const uint8_t samples, const bool edge);
+    static void slice(Channel &ch, const bool bit);
+public:
+    FskDemod();
+    void clear();
+    bool addChannel(const uint8_t tag, const uint16_t bitrate, const uint8_t *sync, const uint8_t syncLen, const uint8_t frameLen);
+    void process(const uint8_t *samples, const uint8_t len);
+    int8_t nextFrame();
+    void releaseFrame(const uint8_t ch);
+    uint8_t getTag(const uint8_t ch) const { return channels[ch].tag; }
+    uint8_t *getFrame(const uint8_t ch) { return channels[ch].frame; }
+    uint8_t getFrameLen(const uint8_t ch) const { return channels[ch].frameLen; }
+    uint32_t getSyncs(const uint8_t ch) const { return channels[ch].syncs; }
+    uint8_t getNumChannels() const { return numChannels; }
+};
@@ -0,0 +1,68 @@
+#include "lora.h"
+
+LoraReceiver::LoraReceiver(RfmBase *radio, const JsonObject &conf):
+        RadioApplication(radio),
+        packets(0),
+        rssi(0),
+        snr(0) {
+    RfmBase::LoraConfig cfg;
+    cfg.spreadingFactor = constrain(conf[F("sf")] | 7, 6, 12);
+    cfg.bandwidth = conf[F("bw")] | 125000;
+    cfg.codingRate = constrain(conf[F("cr")] | 5, 5, 8);
+    cfg.syncWord = conf[F("syncword")] | 0x12;
+    cfg.implicitLen = conf[F("implicitlen")] | 0;
+    cfg.crc = conf[F("crc")] | true;
+
+    radio->setFreq(conf[F("freq")] | LORAFREQ);
+    active = radio->setLora(cfg);
+    if (active)
+        radio->startReceive();
+    else
+        ws.textAll(F("LoRa needs an RFM95 / RFM96 / RFM97 / RFM98"));
+}
+
+void LoraReceiver::loop() {
+    if (!active || !radio->payloadReady())
+        return;
+
+    uint8_t buf[255];
+    const uint8_t len = radio->getPayload(buf);
+    packets++;
+    rssi = radio->getRssi();
+    snr = radio->getSnr();
+    publish(buf, len);
+}
+
+void LoraReceiver::publish(const uint8_t *buf, const uint8_t len) {
+    last.clear();
+    for (uint8_t i=0; i<len; i++) {
+        if (buf[i] < 0x10)
+            last += '0';
+        last += String(buf[i], HEX);
+    }
+
+    String line = F("LoRa payload: ");
+    line += last + ' ' + String(rssi) + F(" dBm, SNR ") + String(snr) + F(" dB");
+    ws.textAll(line);
+
+    if (mqtt.connected()) {
+        JsonDocument payload;
+        payload[F("data")] = last;
+        payload[F("rssi")] = rssi;
+        payload[F("snr")] = snr;
+
+        String topic = baseTopic + F("/lora/rx");
+        mqtt.beginPublish(topic.c_str(), measureJson(payload), false);
+        serializeJson(payload, mqtt);
+        mqtt.endPublish();
+    }
+}
+
+void LoraReceiver::getStatus(JsonObject &obj) {
+    obj[F("active")] = active;
+    obj[F("packets")] = packets;
+    obj[F("crcErrors")] = radio->getCrcErrors();
+    obj[F("rssi")] = rssi;
+    obj[F("snr")] = snr;
+    obj[F("last")] = last;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "../radioapplication.h"
+
+const uint32_t LORAFREQ = 868100000UL;
+
+/**
+ * @brief receives LoRa packets with fixed modem settings and publishes them as hex
+ * Needs a module with LoRa modem (RFM95 / RFM96 / RFM97 / RFM98), reception is continuous.
+ */
+class LoraReceiver: public RadioApplication {
+private:
+    bool active; // the radio accepted the LoRa settings
+    uint32_t packets;
+    int8_t rssi; // of the last packet
+    int8_t snr;
+    String last; // payload of the last packet as hex
+    void publish(const uint8_t *buf, const uint8_t len);
+public:
+    LoraReceiver(RfmBase *radio, const JsonObject &conf);
+    void loop();
+    void getStatus(JsonObject &obj);
+};
@@ -1,16 +1,13 @@
 #include "rc433.h"
 #include "rccodecs.h"
 
-Rc433Transceiver::Rc433Transceiver(const JsonObject &conf) {
-    new ITTristate;
-    new IT32;
-    new PilotaCasa;
-    new EV1527Codec;
-    new Emylo;
+Rc433Transceiver::Rc433Transceiver(RfmBase *radio, const JsonObject &conf):
+        RcPulseTransceiver(radio, conf[F("capture")].as<uint8_t>() == RCCAPTURE_EDGES ? RCCAPTURE_EDGES : RCCAPTURE_FIFO) {
+    RcCodec::begin(RCCODECS_433);
 }
 
 Rc433Transceiver::~Rc433Transceiver() {
-    RcCodec::freeCodecs();
+    RcCodec::end();
 }
 
 
@@ -5,6 +5,6 @@
 class Rc433Transceiver: public RcPulseTransceiver {
 private:
 public:
-    Rc433Transceiver(const JsonObject &conf);
+    Rc433Transceiver(RfmBase *radio, const JsonObject &conf);
     ~Rc433Transceiver();
 };
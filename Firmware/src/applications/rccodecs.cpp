@@ -1,58 +1,413 @@
 #include "rccodecs.h"
 #include "main.h"
 
-const uint16_t BITRATE = 20000;
-const uint16_t PULSEWIDTHUS = 1000000UL / BITRATE; // samplingtime of tranceiver / µS
-
 static const char STR_COMMAND[] PROGMEM = "command";
 
-RcCodec* RcCodec::codecs = nullptr;
+uint32_t RcCodec::activeCodecs = 0;
+uint8_t RcCodec::numCodecs = 0;
+bool RcCodec::classesValid = false;
+uint32_t RcCodec::pulseClasses[256];
+RcCodec::FrameLen RcCodec::frameLens[MAXCODECS];
+uint32_t RcCodec::streamPending = 0;
+uint32_t RcCodec::streamDone = 0;
+bool RcCodec::streamDecoded = false;
+Pulse RcCodec::streamGap = 0xFFFF;
+uint8_t RcCodec::resolution = PULSEWIDTHUS;
+RcCodec::RecentFrame RcCodec::recentFrames[RECENTFRAMES];
+uint32_t RcCodec::recentLookups = 0;
+uint32_t RcCodec::recentHits = 0;
 uint8_t RcCodec::symbolBuf[SYMBOLBUFSIZE];
 uint8_t RcCodec::symbolBufLen;
 
-RcCodec::RcCodec():        
-        next(codecs),
-        lastDecode(0) {
-    codecs = this;
-    name = nullptr;
+#ifndef RCCODEC_EXCLUDE_EV1527
+static EV1527Codec ev1527;
+static constexpr char NAME_EV1527[] PROGMEM = "EV1527";
+#endif
+#ifndef RCCODEC_EXCLUDE_FS20
+static FS20Codec fs20;
+static constexpr char NAME_FS20[] PROGMEM = "FS20";
+#endif
+#ifndef RCCODEC_EXCLUDE_EMYLO
+static Emylo emylo;
+static constexpr char NAME_EMYLO[] PROGMEM = "emylo";
+#endif
+#ifndef RCCODEC_EXCLUDE_INTERTECHNO
+static IT32 it32;
+static constexpr char NAME_INTERTECHNO[] PROGMEM = "intertechno";
+#endif
+#ifndef RCCODEC_EXCLUDE_ITTRISTATE
+static ITTristate itTristate;
+static constexpr char NAME_ITTRISTATE[] PROGMEM = "ittristate";
+#endif
+#ifndef RCCODEC_EXCLUDE_PILOTA
+static PilotaCasa pilotaCasa;
+static constexpr char NAME_PILOTA[] PROGMEM = "pilota";
+#endif
+
+struct CodecEntry {
+    PGM_P name;
+    RcCodec *codec;
+    uint8_t groups; // RcCodecGroup
+};
+
+static constexpr CodecEntry registry[] PROGMEM = {
+    // sorted by name (strcmp), find() uses binary search
+#ifndef RCCODEC_EXCLUDE_EV1527
+    {NAME_EV1527, &ev1527, RCCODECS_433},
+#endif
+#ifndef RCCODEC_EXCLUDE_FS20
+    {NAME_FS20, &fs20, RCCODECS_FS20},
+#endif
+#ifndef RCCODEC_EXCLUDE_EMYLO
+    {NAME_EMYLO, &emylo, RCCODECS_433},
+#endif
+#ifndef RCCODEC_EXCLUDE_INTERTECHNO
+    {NAME_INTERTECHNO, &it32, RCCODECS_433},
+#endif
+#ifndef RCCODEC_EXCLUDE_ITTRISTATE
+    {NAME_ITTRISTATE, &itTristate, RCCODECS_433},
+#endif
+#ifndef RCCODEC_EXCLUDE_PILOTA
+    {NAME_PILOTA, &pilotaCasa, RCCODECS_433},
+#endif
+};
+
+static const uint8_t NUMREGISTRY = sizeof(registry) / sizeof(registry[0]);
+static_assert(NUMREGISTRY <= MAXCODECS, "too many codecs for pulse class bitmasks");
+
+static constexpr int compareNames(const char *a, const char *b) {
+    while ( (*a != 0) && (*a == *b) ) {
+        a++;
+        b++;
+    }
+    return (uint8_t) *a - (uint8_t) *b;
+}
+
+static constexpr bool registrySorted() {
+    for (uint8_t i=1; i<NUMREGISTRY; i++)
+        if (compareNames(registry[i-1].name, registry[i].name) >= 0)
+            return false;
+    return true;
+}
+static_assert(registrySorted(), "codec registry must be sorted by name");
+
+RcCodec::RcCodec():
+        tabTimebase(0),
+        index(0),
+        run(0),
+        footerRun(0),
+        gapPulses(0xFFFF),
+        framePulseCount(0),
+        params(nullptr),
+        fixedTables(nullptr) {
+}
+
+/**
+ * @brief activates all codecs of the given groups (RcCodecGroup bitmask)
+ */
+void RcCodec::begin(const uint8_t groups) {
+    end();
+    for (uint8_t i=0; i<NUMREGISTRY; i++) {
+        if ( (pgm_read_byte(&registry[i].groups) & groups) == 0 )
+            continue;
+        RcCodec *codec = codecAt(i);
+        codec->index = i;
+        codec->tabTimebase = 0;
+        codec->run = 0;
+        codec->footerRun = 0;
+        activeCodecs |= 1UL << i;
+        numCodecs++;
+    }
+}
+
+/**
+ * @brief deactivates all codecs
+ */
+void RcCodec::end() {
+    activeCodecs = 0;
+    numCodecs = 0;
+    classesValid = false;
+    streamPending = 0;
+    streamDone = 0;
+    streamDecoded = false;
+    streamGap = 0xFFFF;
+    memset(recentFrames, 0, sizeof(recentFrames));
+}
+
+RcCodec* RcCodec::codecAt(const uint8_t i) {
+    return (RcCodec*) pgm_read_ptr(&registry[i].codec);
+}
+
+RcCodec::CodecParams RcCodec::getParams() const {
+    CodecParams p;
+    memcpy_P(&p, params, sizeof(p));
+    return p;
+}
+
+/**
+ * @brief add repeat suppression statistics to status object
+ */
+void RcCodec::getStatus(JsonObject &obj) {
+    JsonObject jRecent = obj[F("recentFrames")].to<JsonObject>();
+    const uint32_t now = millis();
+    uint8_t active = 0;
+    for (uint8_t i = 0; i < RECENTFRAMES; i++)
+        if (recentFrames[i].hash != 0 && (int32_t)(now - recentFrames[i].expires) < 0)
+            active++;
+    jRecent[F("size")] = RECENTFRAMES;
+    jRecent[F("active")] = active;
+    jRecent[F("lookups")] = recentLookups;
+    jRecent[F("hits")] = recentHits;
+}
+
+/**
+ * @brief sets the resolution of captured pulses, e.g. the samplingtime of FIFO capture
+ * Matching windows are widened by half the resolution on both sides.
+ */
+void RcCodec::setResolution(const uint8_t us) {
+    if (us == resolution)
+        return;
+    resolution = us;
+    classesValid = false;
+    for (uint32_t m = activeCodecs; m != 0; m &= m - 1)
+        codecAt(__builtin_ctz(m))->tabTimebase = 0;
+}
+
+/**
+ * @brief number of pulses in front of the footer which have to match the codec's symbol table
+ * Very first pulse of a frame is not counted, it could be distorted by leading noise.
+ * 0: codec can't be prefiltered, decodePulses is called for every pulse train
+ */
+uint8_t RcCodec::framePulses() {
+    return pgm_read_byte(&params->numSymbols) * pgm_read_byte(&params->pulsesPerSymbol) - 1;
+}
+
+/**
+ * @brief calculates pulse classes of all registered codecs
+ * Matching windows are calculated for timebase_min / timebase_max of codecs with automatic timebase,
+ * so every pulse matching a codec's table during decoding also matches its pulse class.
+ */
+void RcCodec::calcPulseClasses() {
+    memset(pulseClasses, 0, sizeof(pulseClasses));
+
+    uint8_t n = 0;
+    for (uint32_t m = activeCodecs; m != 0; m &= m - 1) {
+        RcCodec *codec = codecAt(__builtin_ctz(m));
+        const CodecParams p = codec->getParams();
+        uint16_t tbMin = p.timebase;
+        uint16_t tbMax = p.timebase;
+        if (p.numSymbolsAutoTimebase > 0) {
+            tbMin = p.timebase_min - TIMEBASEQUANTUM;
+            tbMax = p.timebase_max + TIMEBASEQUANTUM;
+        }
+
+        Pulse maxHigh = 0;
+        for (uint8_t i=0; i<p.numTableSymbols * p.pulsesPerSymbol; i++) {
+            const Pulse high = matchHigh(tbMax, p.symbolTable[i], p.qDecode, resolution);
+            for (uint16_t v=pulseClass(matchLow(tbMin, p.symbolTable[i], p.qDecode, resolution)); v<=pulseClass(high); v++)
+                pulseClasses[v] |= 1UL << codec->index;
+            if (high > maxHigh)
+                maxHigh = high;
+        }
+        codec->gapPulses = maxHigh < 0xFFFF ? maxHigh + 1 : maxHigh;
+
+        // insert into frameLens, sorted by number of pulses
+        uint8_t i = n++;
+        const uint8_t pulses = codec->framePulses();
+        codec->framePulseCount = pulses;
+        while ( (i > 0) && (frameLens[i-1].pulses > pulses) ) {
+            frameLens[i] = frameLens[i-1];
+            i--;
+        }
+        frameLens[i].pulses = pulses;
+        frameLens[i].index = codec->index;
+    }
+
+    classesValid = true;
+}
+
+/**
+ * @brief classifies the pulses in front of the footer once for all codecs
+ * Pulses are checked backwards from the footer, a codec is dropped at its first pulse not
+ * matching its pulse class. Codecs are done when all pulses of their frame have been checked.
+ * @return bitmask of codecs (index) which may decode the pulse train
+ */
+uint32_t RcCodec::classifyPulses(const PulseView &pulses) {
+    uint32_t candidates = 0xFFFFFFFF;
+    uint32_t done = 0;
+    uint8_t iLen = 0;
+    const uint8_t len = pulses.length();
+
+    for (uint8_t k=1; ; k++) {
+        while ( (iLen < numCodecs) && (frameLens[iLen].pulses < k) )
+            done |= 1UL << frameLens[iLen++].index;
+
+        if ( (candidates & ~done) == 0 )
+            break;
+
+        if (k + 2 > len) {
+            // pulse train is too short for remaining codecs
+            candidates &= done;
+            break;
+        }
+
+        candidates &= pulseClasses[pulseClass(pulses[len - 2 - k])] | done;
+    }
+
+    return candidates;
+}
+
+/**
+ * @brief check whether the frame in symbolBuf was already received within REPEATTIMEOUT
+ * Frames are kept in a small open addressing table keyed by a hash over codec and symbols, so
+ * repeats of several devices using the same codec are suppressed independently. Expired entries
+ * are reused like deleted slots, a hit extends the entry's lifetime while the button is held.
+ */
+bool RcCodec::isRepeat() {
+    uint32_t hash = 2166136261UL; // FNV-1a
+    hash = (hash ^ index) * 16777619UL;
+    for (uint8_t i = 0; i < symbolBufLen; i++)
+        hash = (hash ^ symbolBuf[i]) * 16777619UL;
+    if (hash == 0)
+        hash = 1;
+
+    const uint32_t now = millis();
+    recentLookups++;
+    RecentFrame *slot = nullptr;
+    bool slotFree = false;
+    for (uint8_t i = 0; i < RECENTFRAMES; i++) {
+        RecentFrame &e = recentFrames[(hash + i) & (RECENTFRAMES - 1)];
+        const bool free = e.hash == 0 || (int32_t)(now - e.expires) >= 0;
+        if (e.hash == hash && !free) {
+            e.expires = now + REPEATTIMEOUT;
+            recentHits++;
+            return true;
+        }
+        // insert at first free slot, evict entry expiring first if table is full
+        if (slot == nullptr || (!slotFree && (free || (int32_t)(e.expires - slot->expires) < 0))) {
+            slot = &e;
+            slotFree = free;
+        }
+        if (e.hash == 0)
+            break; // end of probe sequence
+    }
+    slot->hash = hash;
+    slot->expires = now + REPEATTIMEOUT;
+    return false;
+}
+
+/**
+ * @brief publishes decoded symbols, suppressing repeated frames
+ */
+void RcCodec::handleDecoded() {
+    if (!isRepeat())
+        onDecodedPulses();
+}
+
+
+/**
+ * @brief decodes a complete pulse train, called after a seperation gap
+ * Codecs which already handled the frame in decodeStream are skipped.
+ * @return true if pulse train was decoded by any codec
+ */
+bool RcCodec::decode(const PulseView &pulses) {
+    if (!classesValid)
+        calcPulseClasses();
+
+    const uint32_t candidates = classifyPulses(pulses) & ~streamDone;
+    bool decoded = streamDecoded;
+    streamPending = 0;
+    streamGap = 0xFFFF;
+    if (candidates == 0)
+        return decoded;
+
+    for (uint32_t m = candidates & activeCodecs; m != 0; m &= m - 1) {
+        RcCodec *codec = codecAt(__builtin_ctz(m));
+        if (codec->decodePulses(pulses)) {
+            codec->handleDecoded();
+            decoded = true;
+        }
+    }
+    return decoded;
 }
 
-RcCodec::~RcCodec() {
-    if (next) {
-        free(next);
-        next = nullptr;
+/**
+ * @brief feeds a received pulse into the codecs' matchers
+ * Every codec counts the consecutive pulses matching its pulse class. If the pulses in front of
+ * the latest pulse (footer) cover a complete frame, the codec is pending for decodeStream.
+ */
+void RcCodec::addPulse(const Pulse pulse) {
+    if (!classesValid)
+        calcPulseClasses();
+
+    const uint32_t cls = pulseClasses[pulseClass(pulse)];
+    streamPending = 0;
+    streamDone = 0;
+    streamDecoded = false;
+
+    for (uint32_t m = activeCodecs; m != 0; m &= m - 1) {
+        RcCodec *codec = codecAt(__builtin_ctz(m));
+        const uint8_t frame = codec->framePulseCount;
+        codec->footerRun = codec->run;
+        if ( (frame > 0) && (codec->footerRun >= frame) )
+            streamPending |= 1UL << codec->index;
+
+        if ( (cls & (1UL << codec->index)) != 0 ) {
+            if (codec->run < 255)
+                codec->run++;
+        }
+        else
+            codec->run = 0;
     }
+
+    updateStreamGap();
 }
 
-void RcCodec::freeCodecs() {
-    if (codecs != nullptr)
-        delete(codecs);
-    codecs = nullptr;
+void RcCodec::updateStreamGap() {
+    streamGap = 0xFFFF;
+    for (uint32_t m = streamPending; m != 0; m &= m - 1) {
+        const RcCodec *codec = codecAt(__builtin_ctz(m));
+        if (codec->gapPulses < streamGap)
+            streamGap = codec->gapPulses;
+    }
 }
 
-bool RcCodec::decode(const uint8_t *pulseBuf, const uint8_t len) {
+/**
+ * @brief decodes the current frame while its trailing gap is still running
+ * Last pulse is the trailing gap received so far. Pending codecs are decoded as soon
+ * as the gap is longer than any of their symbol pulses, so frames are published before the
+ * seperation gap is complete.
+ * @return true if the frame was decoded by any codec
+ */
+bool RcCodec::decodeStream(const PulseView &pulses) {
+    const Pulse gap = pulses[pulses.length() - 1];
     bool decoded = false;
-    RcCodec *codec = codecs;
-    while (codec != nullptr) {
-        if (codec->decodePulses(pulseBuf, len)) {
-            if (codec->lastDecode < (millis() - 500)) {
-                codec->onDecodedPulses();
-            }
-            else
-                if (memcmp(codec->localSymbolBuf, codec->symbolBuf, codec->symbolBufLen) != 0)
-                    codec->onDecodedPulses();
 
-            memcpy(codec->localSymbolBuf, codec->symbolBuf, codec->symbolBufLen);
-            codec->lastDecode = millis();
+    for (uint32_t m = streamPending; m != 0; m &= m - 1) {
+        RcCodec *codec = codecAt(__builtin_ctz(m));
+        const uint32_t bit = 1UL << codec->index;
+        if (codec->gapPulses > gap)
+            continue;
+
+        streamPending &= ~bit;
+        streamDone |= bit;
+        if (codec->decodePulses(pulses)) {
+            codec->handleDecoded();
             decoded = true;
         }
-        codec = codec->next;
     }
+
+    streamDecoded |= decoded;
+    updateStreamGap();
     return decoded;
 }
 
 uint8_t RcCodec::getTxRepeats() const {
-    return params->txRepeats;
+    return pgm_read_byte(&params->txRepeats);
+}
+
+PGM_P RcCodec::getName() const {
+    return (PGM_P) pgm_read_ptr(&registry[index].name);
 }
 
 /**
@@ -60,72 +415,52 @@ uint8_t RcCodec::getTxRepeats() const {
  * Decoded symbols are saved in static variable "symbolBuffer"
  * @return number of successfully decoded symbols
  */
-bool RcCodec::decodePulses(const uint8_t *pulseBuf, const uint8_t len) {
-    if (len < params->numSymbols * params->pulsesPerSymbol + 2) // enough pulses in received buffer?
+bool RcCodec::decodePulses(const PulseView &pulses) {
+    const CodecParams p = getParams();
+    const uint8_t frameLen = p.numSymbols * p.pulsesPerSymbol + 2;
+    if (pulses.length() < frameLen) // enough pulses in received buffer?
         return false;
 
-    const uint8_t *ppb = pulseBuf + len - params->numSymbols * params->pulsesPerSymbol - 2;
+    const PulseView ppb = pulses.sub(pulses.length() - frameLen, frameLen);
     
-    uint16_t timebase = params->timebase;
+    uint16_t timebase = p.timebase;
     // automatic timebase calculation
-    if (params->numSymbolsAutoTimebase > 0) {
-        uint16_t sumPulses = 0;
-        for (uint8_t i=0; i<params->numSymbolsAutoTimebase * params->pulsesPerSymbol; i++)
+    if (p.numSymbolsAutoTimebase > 0) {
+        uint32_t sumPulses = 0;
+        for (uint8_t i=0; i<p.numSymbolsAutoTimebase * p.pulsesPerSymbol; i++)
             sumPulses += ppb[i];
 
         //calculate duration of a symbol, we always use 1st symbol in symTable
         uint8_t symDur = 0;
-        for (uint8_t i=0; i<params->pulsesPerSymbol; i++)
-            symDur += params->symbolTable[i];
+        for (uint8_t i=0; i<p.pulsesPerSymbol; i++)
+            symDur += p.symbolTable[i];
 
-        timebase = (uint32_t) sumPulses * PULSEWIDTHUS / params->numSymbolsAutoTimebase / symDur;
-        if ( (timebase < params->timebase_min) || (timebase > params->timebase_max) )
+        timebase = sumPulses / p.numSymbolsAutoTimebase / symDur;
+        if ( (timebase < p.timebase_min) || (timebase > p.timebase_max) )
             return false;
     }
 
-    uint8_t *symTabLow = (uint8_t*) malloc(params->numTableSymbols * params->pulsesPerSymbol);
-    uint8_t *symTabHigh = (uint8_t*) malloc(params->numTableSymbols * params->pulsesPerSymbol);
-
-    // calculate matching windows for pulses
-
-    #ifdef DEBUGMATCHINGTABLES
-    Serial.print("Matching table: ");
-    #endif
-    for (uint8_t s=0; s<params->numTableSymbols; s++) {
-        for (uint8_t p=0; p<params->pulsesPerSymbol; p++) {
-            uint8_t i = s * params->pulsesPerSymbol + p;
-            
-            // calculate matching windows in units of receiver's samplingtime
-            symTabLow[i] = ((timebase * params->symbolTable[i] * (params->qDecode-1)) / params->qDecode + PULSEWIDTHUS / 2) / PULSEWIDTHUS;
-            symTabHigh[i] = ((timebase * params->symbolTable[i] * (params->qDecode+1)) / params->qDecode + PULSEWIDTHUS / 2) / PULSEWIDTHUS;
-            #ifdef DEBUGMATCHINGTABLES
-            Serial.print(String(symTabLow[i]) + '-' + String(symTabHigh[i]) + ',');
-            #endif
-        }
-    }
-    #ifdef DEBUGMATCHINGTABLES
-    Serial.println("");
-    #endif
+    calcMatchingTables(timebase);
 
     uint8_t bp = 0;
     symbolBufLen = 0;
 
-    while (bp + params->pulsesPerSymbol <= len) {
+    while (bp + p.pulsesPerSymbol <= frameLen) {
         uint8_t s;
 
         #ifdef DEBUGRCDECODER
         Serial.print("Matching pulses ");
-        for (uint8_t p=0; p<params->pulsesPerSymbol; p++)
-            Serial.print(String(pulseBuf[bp+p]) + ' ');
+        for (uint8_t i=0; i<p.pulsesPerSymbol; i++)
+            Serial.print(String(ppb[bp+i]) + ' ');
         Serial.print(": ");
         #endif
 
-        for (s=0; s<params->numTableSymbols; s++) {
-            uint8_t p;
+        for (s=0; s<p.numTableSymbols; s++) {
+            uint8_t i;
 
-            for (p=0; p<params->pulsesPerSymbol; p++) {
-                const uint8_t ist = s * params->pulsesPerSymbol + p; // calculate index in symboltable
-                const uint8_t ipb = bp + p; // calculate index in pulse buffer
+            for (i=0; i<p.pulsesPerSymbol; i++) {
+                const uint8_t ist = s * p.pulsesPerSymbol + i; // calculate index in symboltable
+                const uint8_t ipb = bp + i; // calculate index in pulse buffer
                 if (ipb == 0) // skip very first pulse, it could be distorted by leading noise
                     continue;
                 if ( (ppb[ipb] < symTabLow[ist]) || (ppb[ipb] > symTabHigh[ist]) )
@@ -133,10 +468,10 @@ bool RcCodec::decodePulses(const uint8_t *pulseBuf, const uint8_t len) {
             }
 
             #ifdef DEBUGRCDECODER
-            Serial.print("p " + String(p) + ", ");
+            Serial.print("p " + String(i) + ", ");
             #endif
 
-            if (p == params->pulsesPerSymbol) {
+            if (i == p.pulsesPerSymbol) {
                 // matching symbol found, continue with checking next pulses!
                 break;
             }
@@ -147,14 +482,14 @@ bool RcCodec::decodePulses(const uint8_t *pulseBuf, const uint8_t len) {
         Serial.println("s " + String(s));
         #endif
 
-        if (s == params->numTableSymbols) {
+        if (s == p.numTableSymbols) {
             //no matching symbol found
             break;
         }
         else
             symbolBuf[symbolBufLen++] = s;
 
-        bp += params->pulsesPerSymbol;
+        bp += p.pulsesPerSymbol;
     }
 
     #ifdef DEBUGRCDECODER
@@ -164,62 +499,114 @@ bool RcCodec::decodePulses(const uint8_t *pulseBuf, const uint8_t len) {
     Serial.println("RX Symbols: " + str);
     #endif
 
-    free(symTabLow);
-    free(symTabHigh);
+    return (p.numSymbols == bp / p.pulsesPerSymbol);
+}
 
-    return (params->numSymbols == bp / params->pulsesPerSymbol);
+/**
+ * @brief calculates matching windows for pulses in µS
+ * Tables are cached, they are recalculated only if timebase leaves the current bucket of TIMEBASEQUANTUM µS
+ */
+void RcCodec::calcMatchingTables(const uint16_t timebase) {
+    const uint16_t bucket = timebase / TIMEBASEQUANTUM * TIMEBASEQUANTUM + TIMEBASEQUANTUM / 2;
+    if (bucket == tabTimebase)
+        return;
+    tabTimebase = bucket;
+
+    if ( (fixedTables != nullptr) && ((resolution == PULSEWIDTHUS) || (resolution == EDGERESOLUTIONUS)) ) {
+        // tables of fixed timebase codecs are built at compile time for both capture modes
+        const MatchingTable *tab = &fixedTables[resolution == PULSEWIDTHUS ? 0 : 1];
+        memcpy_P(symTabLow, tab->low, sizeof(symTabLow));
+        memcpy_P(symTabHigh, tab->high, sizeof(symTabHigh));
+        return;
+    }
+
+    // fixed timebase codecs use the exact timebase, tables are calculated only once
+    const CodecParams p = getParams();
+    const uint16_t tb = p.numSymbolsAutoTimebase > 0 ? bucket : timebase;
+
+    #ifdef DEBUGMATCHINGTABLES
+    Serial.print("Matching table: ");
+    #endif
+    for (uint8_t i=0; i<p.numTableSymbols * p.pulsesPerSymbol; i++) {
+        symTabLow[i] = matchLow(tb, p.symbolTable[i], p.qDecode, resolution);
+        symTabHigh[i] = matchHigh(tb, p.symbolTable[i], p.qDecode, resolution);
+        #ifdef DEBUGMATCHINGTABLES
+        Serial.print(String(symTabLow[i]) + '-' + String(symTabHigh[i]) + ',');
+        #endif
+    }
+    #ifdef DEBUGMATCHINGTABLES
+    Serial.println("");
+    #endif
 }
 
+/**
+ * @brief binary search for an active codec in the registry
+ */
 RcCodec* RcCodec::find(const String name) {
-    RcCodec* codec = codecs;
-    while (codec != nullptr) {
-        if (codec->name != nullptr) {
-            if (name.compareTo(codec->name) == 0)
-                return codec;
-        }
-        codec = codec->next;
+    uint8_t lo = 0;
+    uint8_t hi = NUMREGISTRY;
+    while (lo < hi) {
+        const uint8_t mid = (lo + hi) / 2;
+        const int cmp = strcmp_P(name.c_str(), (PGM_P) pgm_read_ptr(&registry[mid].name));
+        if (cmp == 0)
+            return (activeCodecs & (1UL << mid)) != 0 ? codecAt(mid) : nullptr;
+        if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
     }
     return nullptr;
 }
 
-RcCodec* RcCodec::encode(String path, String payload, uint8_t *pulseBuf, uint8_t &pulseBufLen) {
+/**
+ * @brief encodes a command given by path & payload
+ * Encoded symbols are saved in static variable "symbolBuf"
+ * @return codec used for encoding, nullptr if no codec was able to encode
+ */
+RcCodec* RcCodec::encode(String path, String payload) {
     String name = path.substring(0, path.indexOf('/'));
 
     RcCodec* codec = find(name);
     if (codec != nullptr) {
         // strip off protocol name
         path = path.substring(path.indexOf('/') + 1, -1);
-        if (codec->encodeSymbols(path, payload)) {
-            pulseBufLen = codec->encodePulses(pulseBuf);
+        if (codec->encodeSymbols(path, payload))
             return codec;
-        }
     }
     
     return nullptr;
 }
 
-RcCodec* RcCodec::encode(const JsonObject& obj, uint8_t *pulseBuf, uint8_t &pulseBufLen) {
+RcCodec* RcCodec::encode(const JsonObject& obj) {
     String name = obj[F("protocol")];
 
     RcCodec* codec = find(name);
     if (codec != nullptr) {
-        if (codec->encodeSymbols(obj)) {
-            pulseBufLen = codec->encodePulses(pulseBuf);
+        if (codec->encodeSymbols(obj))
             return codec;
-        }
     }
 
     return nullptr;
 }
 
-uint8_t RcCodec::encodePulses(uint8_t *pulseBuf) {
+/**
+ * @brief encodes previously encoded symbols to pulses
+ * 
+ * @return number of pulses
+ */
+uint8_t RcCodec::encodeFrame(const uint8_t *symbols, const uint8_t numSymbols, Pulse *pulseBuf) {
+    memcpy(symbolBuf, symbols, numSymbols);
+    symbolBufLen = numSymbols;
+    return encodePulses(pulseBuf);
+}
+
+uint8_t RcCodec::encodePulses(Pulse *pulseBuf) {
+    const CodecParams cp = getParams();
     uint8_t result = 0;
     
     for (uint8_t s=0; s<symbolBufLen; s++) {
-        for (uint8_t p=0; p<params->pulsesPerSymbol; p++) {
-            uint16_t pulse = (params->symbolTable[symbolBuf[s] * params->pulsesPerSymbol + p] * params->timebase + (PULSEWIDTHUS / 2)) / PULSEWIDTHUS;
-            pulseBuf[result++] = pulse;
-        }
+        for (uint8_t p=0; p<cp.pulsesPerSymbol; p++)
+            pulseBuf[result++] = cp.symbolTable[symbolBuf[s] * cp.pulsesPerSymbol + p] * cp.timebase;
     }
     return result;
 }
@@ -262,6 +649,7 @@ uint32_t RcCodec::decodeBinLSB() {
  * publish RF received data
  */
 void RcCodec::publish(String path, String payload, JsonDocument &doc) {
+    PGM_P name = getName();
     String topic = baseTopic + '/' + name + '/' + path;
     mqtt.publish(topic.c_str(), payload.c_str());
 
@@ -282,7 +670,7 @@ void RcCodec::publish(String path, String payload, JsonDocument &doc) {
 }
 
 
-RcCodec::CodecParams TristateCodec::defParams = {
+const RcCodec::CodecParams TristateCodec::defParams PROGMEM = {
     350,        // timebase
     300, 400,   // timebase min / max
     12,         // numSymbols
@@ -305,10 +693,6 @@ TristateCodec::TristateCodec() {
 }
 
 
-ITTristate::ITTristate() {
-    name = PSTR("ittristate");
-}
-
 bool ITTristate::encodeSymbols(const char house, const uint8_t group, const uint8_t channel, const bool on) {
     char sub = 0;
     if ( (house >= 'A') && (house <= 'P') )
@@ -398,7 +782,7 @@ void ITTristate::onDecodedPulses() {
 
 
 
-RcCodec::CodecParams IT32::defParams = {
+const RcCodec::CodecParams IT32::defParams PROGMEM = {
     275,        // timebase
     250, 350,   // timebase min / max
     32,         // numSymbols; dimmers may have for symbols
@@ -416,13 +800,12 @@ RcCodec::CodecParams IT32::defParams = {
 };
 
 IT32::IT32() {
-    name = PSTR("intertechno");
     params = &defParams;
 }
 
-uint8_t IT32::encodePulses(uint8_t *pulseBuf) {
-    pulseBuf[0] = 1;
-    pulseBuf[1] = 60;
+uint8_t IT32::encodePulses(Pulse *pulseBuf) {
+    pulseBuf[0] = 50;
+    pulseBuf[1] = 3000;
     return RcCodec::encodePulses(&pulseBuf[2]) + 2;
 }
 
@@ -451,9 +834,9 @@ bool IT32::encodeSymbols(const JsonObject &obj) {
 
 }
 
-bool IT32::decodePulses(const uint8_t *pulseBuf, const uint8_t len) {
+bool IT32::decodePulses(const PulseView &pulses) {
     // TODO check also for special (longer) frames for dimmers
-    return RcCodec::decodePulses(pulseBuf, len);
+    return RcCodec::decodePulses(pulses);
 }
 
 void IT32::onDecodedPulses() {
@@ -498,7 +881,7 @@ PilotaCasa::CmdTable PilotaCasa::cmdTable[] = {
 	{0b101100, 0, 0, 1}, {0b011100, 0, 0, 0}
 };
 
-RcCodec::CodecParams PilotaCasa::defParams = {
+const RcCodec::CodecParams PilotaCasa::defParams PROGMEM = {
     600,        // timebase
     500, 700,   // timebase min / max
     32,         // numSymbols
@@ -515,7 +898,6 @@ RcCodec::CodecParams PilotaCasa::defParams = {
 };
 
 PilotaCasa::PilotaCasa() {
-    name = PSTR("pilota");
     params = &defParams;
 }
 
@@ -581,7 +963,7 @@ void PilotaCasa::onDecodedPulses() {
     }
 }
 
-RcCodec::CodecParams EV1527Codec::defParams = {
+const RcCodec::CodecParams EV1527Codec::defParams PROGMEM = {
     250,        // timebase
     220, 360,   // timebase min / max
     24,         // numSymbols
@@ -598,7 +980,6 @@ RcCodec::CodecParams EV1527Codec::defParams = {
 };
 
 EV1527Codec::EV1527Codec() {
-    name = PSTR("EV1527");
     params = &defParams;
 }
 
@@ -646,10 +1027,6 @@ void EV1527Codec::onDecodedPulses() {
 }
 
 
-Emylo::Emylo() {
-    name = PSTR("emylo");
-}
-
 bool Emylo::encodeSymbols(String path, String payload) {
     // path for Emylo: <ID>, payload: 'A'-'D'
     const uint32_t code = getPathSegment(path, 0).toInt();
@@ -697,7 +1074,7 @@ void Emylo::onDecodedPulses() {
 }
 
 
-RcCodec::CodecParams FS20Codec::defParams = {
+static constexpr RcCodec::CodecParams FS20PARAMS = {
     200,        // timebase
     150, 250,   // timebase min / max
     10,         // 13 sync + 18 housecode + 9 address + 9 command + 9 checksum + 1 stop, optional + 9 bits extended command TODO numSymbols
@@ -712,10 +1089,17 @@ RcCodec::CodecParams FS20Codec::defParams = {
         3, 3    // symbol 1: 0b1
     }
 };
+static_assert(FS20PARAMS.numSymbolsAutoTimebase == 0, "matching tables in flash need a fixed timebase");
+
+const RcCodec::CodecParams FS20Codec::defParams PROGMEM = FS20PARAMS;
+const RcCodec::MatchingTable FS20Codec::defTables[] PROGMEM = {
+    matchingTable(FS20PARAMS, PULSEWIDTHUS),
+    matchingTable(FS20PARAMS, EDGERESOLUTIONUS)
+};
 
 FS20Codec::FS20Codec() {
-    name = PSTR("FS20");
     params = &defParams;
+    fixedTables = defTables;
 }
 
 bool FS20Codec::encodeSymbols(String path, String payload) {
@@ -727,11 +1111,14 @@ bool FS20Codec::encodeSymbols(const JsonObject &obj) {
     return true;
 }
 
-bool FS20Codec::decodePulses(const uint8_t *pulseBuf, const uint8_t len) {
-    if (len >= 117) {
-        const uint8_t *p = pulseBuf + len - 115; // omitt decoding of 1st symbol as first pulse might be enlarged by noise
+uint8_t FS20Codec::framePulses() {
+    return 0;
+}
 
-        uint8_t numSymbols = RcCodec::decodePulses(p, len - 2);
+bool FS20Codec::decodePulses(const PulseView &pulses) {
+    if (pulses.length() >= 117) {
+        // omitt decoding of 1st symbol as first pulse might be enlarged by noise
+        uint8_t numSymbols = RcCodec::decodePulses(pulses.sub(pulses.length() - 115, 115));
         return numSymbols;
     }
 
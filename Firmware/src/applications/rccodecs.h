@@ -4,16 +4,58 @@
 //#include "rcpulse.h"
 
 const uint8_t SYMBOLBUFSIZE = 40;
-extern const uint16_t BITRATE;
+const uint8_t MAXTABLEPULSES = 16; // max. numTableSymbols * pulsesPerSymbol of all codecs
+const uint8_t MAXCODECS = 32; // max. number of codecs, one bit per codec in pulse classes
+const uint8_t TIMEBASEQUANTUM = 4; // resolution / µS of cached matching tables for automatic timebase
+const uint16_t BITRATE = 20000;
+const uint16_t PULSEWIDTHUS = 1000000UL / BITRATE; // samplingtime of tranceiver / µS
+const uint8_t EDGERESOLUTIONUS = 2; // edge timestamps of continuous RX are even
+const uint8_t PULSECLASSSHIFT = 5; // pulse classes are buckets of 32 µS
+const uint8_t RECENTFRAMES = 16; // size of repeat suppression table, power of 2
+const uint16_t REPEATTIMEOUT = 500; // ms after last reception a repeated frame is published again
 
-class RcCodec {
+typedef uint16_t Pulse; // pulse length / µS
+
+/**
+ * @brief groups of codecs in the codec registry, activated together by an application
+ */
+enum RcCodecGroup : uint8_t {
+    RCCODECS_433 = 1 << 0,
+    RCCODECS_FS20 = 1 << 1
+};
+
+/**
+ * @brief read only view on received pulses, located in a ringbuffer or a linear buffer
+ * Index 0 is the oldest pulse, indices wrap around at the end of the ringbuffer.
+ */
+class PulseView {
 private:
-    RcCodec *next;
-    uint32_t lastDecode;
-    uint8_t localSymbolBuf[SYMBOLBUFSIZE];
-    static RcCodec *codecs;
-    static RcCodec* find(const String name);
-protected:
+    const Pulse *base;
+    uint8_t size;
+    uint8_t start;
+    uint8_t len;
+public:
+    PulseView(const Pulse *buf, const uint8_t size, const uint8_t start, const uint8_t len):
+        base(buf), size(size), start(start), len(len) {}
+    PulseView(const Pulse *buf, const uint8_t len):
+        base(buf), size(len), start(0), len(len) {}
+    Pulse operator[](const uint8_t i) const {
+        const uint16_t pos = start + i;
+        return base[pos < size ? pos : pos - size];
+    }
+    uint8_t length() const { return len; }
+    PulseView sub(const uint8_t offset, const uint8_t sublen) const {
+        return PulseView(base, size, (start + offset) % size, sublen);
+    }
+};
+
+/**
+ * @brief base class of all codecs
+ * Codecs are static instances listed in a registry in flash, sorted by name. Single codecs can be
+ * excluded from the build by defining RCCODEC_EXCLUDE_<NAME>, e.g. RCCODEC_EXCLUDE_PILOTA.
+ */
+class RcCodec {
+public:
     struct CodecParams {
         uint16_t timebase; // timebase in µS
         uint16_t timebase_min; //
@@ -25,28 +67,118 @@ protected:
         uint8_t qDecode; // "quality factor": matching windows go from x-(x/qDecode) to x+(x/qDecode)
         uint16_t footer[2];
         uint8_t txRepeats; // number of tx tries
-        uint8_t symbolTable[];
-    } *params;
-    virtual uint8_t encodePulses(uint8_t *pulseBuf);
+        uint8_t symbolTable[MAXTABLEPULSES];
+    };
+private:
+    uint16_t tabTimebase; // timebase bucket matching tables are valid for, 0 = not calculated
+    Pulse symTabLow[MAXTABLEPULSES];
+    Pulse symTabHigh[MAXTABLEPULSES];
+    uint8_t index; // position in codec registry, bit in pulseClasses
+    uint8_t run; // number of consecutive received pulses matching pulse class
+    uint8_t footerRun; // run before last received pulse (footer)
+    Pulse gapPulses; // trailing gap which can't be a symbol pulse any more
+    uint8_t framePulseCount; // cached framePulses()
+    static uint32_t activeCodecs; // bit n set: codec at registry position n is active
+    static uint8_t numCodecs; // number of active codecs
+    static bool classesValid;
+    static uint32_t pulseClasses[256]; // bit n set: pulse of bucket (pulse >> PULSECLASSSHIFT) may be part of a frame of codec with index n
+    static struct FrameLen {
+        uint8_t pulses;
+        uint8_t index;
+    } frameLens[MAXCODECS]; // sorted by pulses
+    static uint32_t streamPending; // codecs waiting for the trailing gap of the current frame
+    static uint32_t streamDone; // codecs already decoded for the current frame
+    static bool streamDecoded;
+    static Pulse streamGap;
+    static uint8_t resolution; // µS, matching windows are widened by resolution / 2
+    static struct RecentFrame {
+        uint32_t hash; // hash of codec and symbols, 0 = slot never used
+        uint32_t expires; // millis() until which the frame counts as repeat
+    } recentFrames[RECENTFRAMES];
+    static uint32_t recentLookups;
+    static uint32_t recentHits;
+    static RcCodec* codecAt(const uint8_t i);
+    static RcCodec* find(const String name);
+    static void calcPulseClasses();
+    static uint32_t classifyPulses(const PulseView &pulses);
+    void calcMatchingTables(const uint16_t timebase);
+    void handleDecoded();
+    bool isRepeat();
+    static void updateStreamGap();
+    static uint8_t pulseClass(const Pulse pulse) {
+        return (pulse >> PULSECLASSSHIFT) < 255 ? pulse >> PULSECLASSSHIFT : 255;
+    }
+protected:
+    /**
+     * @brief matching windows in µS of every pulse in a symbol table
+     */
+    struct MatchingTable {
+        Pulse low[MAXTABLEPULSES];
+        Pulse high[MAXTABLEPULSES];
+    };
+    const CodecParams *params; // located in flash (PROGMEM), read with getParams()
+    const MatchingTable *fixedTables; // fixed timebase codecs: in flash for PULSEWIDTHUS and EDGERESOLUTIONUS, nullptr: calculated at runtime
+    CodecParams getParams() const;
+    virtual uint8_t encodePulses(Pulse *pulseBuf);
     virtual bool encodeSymbols(String path, String payload) = 0;
     virtual bool encodeSymbols(const JsonObject &obj) = 0;
-    virtual bool decodePulses(const uint8_t *pulseBuf, const uint8_t len);
+    virtual bool decodePulses(const PulseView &pulses);
+    virtual uint8_t framePulses();
     virtual void onDecodedPulses() {}
     String getPathSegment(const String path, const uint8_t index);
     void publish(String path, String payload, JsonDocument &doc);
     void encodeBinLSB(const uint32_t val, const uint8_t bits, const uint8_t iHighSymbol=1);
     uint32_t decodeBinLSB();
-    PGM_P name;
+
+    /**
+     * @brief lower / upper limit of matching window for a pulse in µS
+     * 
+     * @param timebase timebase in µS
+     * @param len pulse length in units of timebase
+     * @param q quality factor, matching windows go from x-(x/q) to x+(x/q)
+     * @param res resolution of captured pulses in µS
+     */
+    static constexpr Pulse matchLow(const uint16_t timebase, const uint8_t len, const uint8_t q, const uint8_t res) {
+        return (uint32_t) timebase * len * (q - 1) / q - res / 2;
+    }
+    static constexpr Pulse matchHigh(const uint16_t timebase, const uint8_t len, const uint8_t q, const uint8_t res) {
+        const uint32_t high = (uint32_t) timebase * len * (q + 1) / q + res / 2;
+        return high < 0xFFFF ? high : 0xFFFF;
+    }
+
+    /**
+     * @brief matching windows of a fixed timebase codec, for its tables in flash
+     */
+    static constexpr MatchingTable matchingTable(const CodecParams &p, const uint8_t res) {
+        MatchingTable tab = {};
+        for (uint8_t i=0; i<p.numTableSymbols * p.pulsesPerSymbol; i++) {
+            tab.low[i] = matchLow(p.timebase, p.symbolTable[i], p.qDecode, res);
+            tab.high[i] = matchHigh(p.timebase, p.symbolTable[i], p.qDecode, res);
+        }
+        return tab;
+    }
 public:
     static uint8_t symbolBuf[SYMBOLBUFSIZE];
     static uint8_t symbolBufLen;
     RcCodec();
-    virtual ~RcCodec();
-    static void freeCodecs();
-    static RcCodec* encode(String path, String payload, uint8_t *pulseBuf, uint8_t &pulseBufLen);
-    static RcCodec* encode(const JsonObject& obj, uint8_t *pulseBuf, uint8_t &pulseBufLen);
-    static bool decode(const uint8_t *pulseBuf, const uint8_t len);
+    virtual ~RcCodec() {}
+    static void begin(const uint8_t groups);
+    static void end();
+    static RcCodec* encode(String path, String payload);
+    static RcCodec* encode(const JsonObject& obj);
+    uint8_t encodeFrame(const uint8_t *symbols, const uint8_t numSymbols, Pulse *pulseBuf);
+    static bool decode(const PulseView &pulses);
+    static void addPulse(const Pulse pulse);
+    static void setResolution(const uint8_t us);
+    static bool decodeStream(const PulseView &pulses);
+    /**
+     * @brief length of trailing gap / µS at which decodeStream can decode the current frame
+     * 0xFFFF: no codec pending
+     */
+    static Pulse getStreamGap() { return streamGap; }
+    static void getStatus(JsonObject &obj);
     uint8_t getTxRepeats() const;
+    PGM_P getName() const;
 };
 
 /* Tristate coding (Intertechno old, ...)
@@ -68,7 +200,7 @@ Sync :  _|    |___________ _ _ _ ____________
 */
 class TristateCodec: public RcCodec {
 private:
-    static RcCodec::CodecParams defParams;
+    static const RcCodec::CodecParams defParams;
 public:
     TristateCodec();
 };
@@ -79,8 +211,6 @@ protected:
     bool encodeSymbols(const char house, const uint8_t group, const uint8_t channel, const bool on);
     bool encodeSymbols(String path, String payload);
     bool encodeSymbols(const JsonObject &obj);
-public:
-    ITTristate();
 };
 
 
@@ -104,13 +234,13 @@ Sync     : _|    |_________ _ _ _ ________
 */
 class IT32: public RcCodec {
 private:
-    static RcCodec::CodecParams defParams;
+    static const RcCodec::CodecParams defParams;
 protected:
     void encodeInt(const uint32_t val, const uint8_t bits);
-    uint8_t encodePulses(uint8_t *pulseBuf);
+    uint8_t encodePulses(Pulse *pulseBuf);
     bool encodeSymbols(String path, String payload);
     bool encodeSymbols(const JsonObject &obj);
-    bool decodePulses(const uint8_t *pulseBuf, const uint8_t len);
+    bool decodePulses(const PulseView &pulses);
     void onDecodedPulses();
 public:
     IT32();
@@ -135,7 +265,7 @@ private:
         uint8_t channel; // 1..4 0 all
         uint8_t cmd; // 0 off, 1 on
     } cmdTable[];
-    static RcCodec::CodecParams defParams;
+    static const RcCodec::CodecParams defParams;
 protected:
     bool encodeSymbols(String path, String payload);
     bool encodeSymbols(const JsonObject &obj);
@@ -157,7 +287,7 @@ Bit 1    : _|            |____
 */
 class EV1527Codec: public RcCodec {
 private:
-    static RcCodec::CodecParams defParams;
+    static const RcCodec::CodecParams defParams;
 protected:
     void encodeSymbols(const uint32_t code, const uint8_t data);
     bool encodeSymbols(String path, String payload);
@@ -173,19 +303,18 @@ protected:
     bool encodeSymbols(String path, String payload);
     bool encodeSymbols(const JsonObject &obj);
     void onDecodedPulses();
-public:
-    Emylo();
-
 };
 
 
 class FS20Codec: public RcCodec {
 private:
-    static RcCodec::CodecParams defParams;
+    static const RcCodec::CodecParams defParams;
+    static const MatchingTable defTables[2];
 protected:
     bool encodeSymbols(String path, String payload);
     bool encodeSymbols(const JsonObject &obj);
-    bool decodePulses(const uint8_t *pulseBuf, const uint8_t len);
+    bool decodePulses(const PulseView &pulses);
+    uint8_t framePulses();
     void onDecodedPulses();
 public:
     FS20Codec();
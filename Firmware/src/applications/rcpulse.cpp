@@ -1,150 +1,209 @@
 #include "rcpulse.h"
 
-const uint8_t SEPERATION_LEN = 120;
+const uint16_t SEPERATIONUS = 6000; // gap between frames
+const uint16_t MINPULSEUS = PULSEWIDTHUS / 2; // shorter pulses in edge capture are glitches
+const uint16_t TXFOOTER_HIGH = 250; // µS
+const uint16_t TXFOOTER_LOW = 7500; // µS
+const uint8_t TXFIFOTHRESH = 32; // refill FIFO if it holds TXFIFOTHRESH bytes or less
+const uint8_t TXBURSTLEN = 32; // bytes written to FIFO at once
+const uint8_t TXFRAMESPERTURN = 2; // consecutive frames of a queued command before switching to next one
 
-RcPulseTransceiver::RcPulseTransceiver():
+RcPulseTransceiver::RcPulseTransceiver(RfmBase *radio, const RcCapture capture):
+        RadioApplication(radio),
         bufPos(0),
         bufLen(0),
         lastBit(false),
-        pulseLen(1),
-        txMode(TX_IDLE) {
-    //rfm69->setFreq(868350000UL);
-    rfm69->setFreq(433920000UL);
+        pulseLen(PULSEWIDTHUS),
+        edgeCapture(capture == RCCAPTURE_EDGES),
+        lastEdgeTime(0),
+        txMode(TX_IDLE),
+        txQueueLen(0),
+        txSlot(0),
+        txTurnFrames(0),
+        txQueueMax(0),
+        txLatencyLast(0),
+        txLatencyMax(0),
+        txSent(0),
+        txRejected(0) {
+    for (uint8_t i=0; i<TXQUEUESIZE; i++)
+        txQueue[i].codec = nullptr;
 
-    Rfm69::Rfm69Config cfg[] = {
-        {Rfm69::RegRxBw, 2<<5 | Rfm69::RXBWASK_250KHZ},
-        {Rfm69::RegSyncConfig, 1<<6}, 
-        {Rfm69::RegRssiThresh, 180}, // /-0.5 dBm
-        {Rfm69::RegDataModul, 1<<3}, // OOK
-        {Rfm69::RegOokPeak, 1<<6 | 3<<0}, // peak threshold, increment every 8 chips
-        {Rfm69::RegPreambleMsb, 0},
-        {Rfm69::RegPreambleLsb, 0},
-        {Rfm69::RegPacketConfig1, 0x00}, // fixed or unlimited length, no whitening, no crc
-    };
+    //radio->setFreq(868350000UL);
+    radio->setFreq(433920000UL);
+    radio->setModulation(RfmBase::MODULATION_OOK);
+    radio->setRxBandwidth(250000);
+    radio->setSync(nullptr, 0);
+    radio->setRssiThreshold(180); // /-0.5 dBm
+    radio->setPreamble(0);
+    radio->setFifoThreshold(TXFIFOTHRESH);
+    radio->setBitrate(BITRATE);
+    radio->setTxPower(13);
 
-    rfm69->writeConfig(cfg, sizeof(cfg) / sizeof(cfg[0]));
-    rfm69->setBitrate(BITRATE);
-    rfm69->setTxPower(13);
+    startCapture();
+}
 
-    rfm69->startReceive(0);
+/**
+ * @brief (re)starts reception in the selected capture mode, falls back to FIFO without DIO2
+ */
+void RcPulseTransceiver::startCapture() {
+    if (edgeCapture && !radio->startReceiveContinuous()) {
+        ws.textAll(F("DIO2 not connected, capturing via FIFO"));
+        edgeCapture = false;
+    }
+    if (!edgeCapture)
+        radio->startReceive(0);
+    lastEdgeTime = micros();
+    RcCodec::setResolution(edgeCapture ? EDGERESOLUTIONUS : PULSEWIDTHUS);
 }
 
 void RcPulseTransceiver::loop() {
     if (txMode > TX_IDLE) {
-        while (rfm69->getFifoLevel() < Rfm69::FIFO_FULL) {
-            uint8_t txbyte = 0x00;
-            uint8_t bitmask = 0x80;
-
-            while (bitmask) {
-                if (lastBit)
-                    txbyte |= bitmask;
-                bitmask >>= 1;
-
-                pulseLen--;
-                if (pulseLen == 0) {
-                    switch (txMode) {
-                    case TX_SYMBOLS:
-                        if (bufPos == bufLen) {
-                            pulseLen = 5;
-                            txMode = TX_FOOTER1;
-                            break;
-                        }
-                        else
-                            pulseLen = pulseBuf[bufPos++];
-                        break;
-
-                    case TX_FOOTER1:
-                        pulseLen = 150;
-                        txMode = TX_FOOTER2;
-                        break;
-
-                    case TX_FOOTER2:
-                        if (txRepeats > 0) {
-                            txRepeats--;
-                            txMode = TX_SYMBOLS;
-                            bufPos = 0;
-                            pulseLen = pulseBuf[bufPos++];
-                        }
-                        else {
-                            txMode = TX_IDLE;
-                            rfm69->startReceive(0);
-                        return;
-                        }
-                    default:
-                        break;
-                    }
-
-                    lastBit = !lastBit;
+        const RfmBase::FifoLevel level = radio->getFifoLevel();
+        if (txMode == TX_DRAIN) {
+            if (level == RfmBase::FIFO_EMPTY) {
+                if ( (txQueueLen > 0) && nextFrame() ) {
+                    // queued while draining, queueFrame() only starts from TX_IDLE
+                    txMode = TX_CHIPS;
+                    radio->send(nullptr, 0, false);
+                }
+                else {
+                    // last chip sent, back to receive. pulseBuf was used for encoding, restart capturing
+                    txMode = TX_IDLE;
+                    bufPos = 0;
+                    bufLen = 0;
+                    lastBit = false;
+                    pulseLen = PULSEWIDTHUS;
+                    startCapture();
                 }
             }
-
-            rfm69->writeFifo(&txbyte, sizeof(txbyte));
+        }
+        else if (level < RfmBase::FIFO_THRESH) {
+            uint8_t burst[TXBURSTLEN];
+            uint8_t n = 0;
+            while ( (n < sizeof(burst)) && (txMode == TX_CHIPS) )
+                burst[n++] = nextTxByte();
+            radio->writeFifo(burst, n);
         }
         return;
     }
 
+    if (edgeCapture) {
+        captureEdges();
+        return;
+    }
 
     uint8_t buf[32];
-    uint8_t len = rfm69->getPayload(buf, sizeof(buf));
+    uint8_t len = radio->getPayload(buf, sizeof(buf));
 
     for (uint8_t i=0; i<len; i++) {
-        for (uint8_t mask=0x80; mask > 0; mask >>= 1) {
-            if ( ((buf[i] & mask) != 0) != lastBit ) {
-                
-                if (pulseLen > SEPERATION_LEN)
-                    pulseLen = SEPERATION_LEN;
-                    
-                pulseBuf[bufPos++] = pulseLen;
-                if (bufPos == sizeof(pulseBuf))
-                    bufPos = 0;
-                if (bufLen < sizeof(pulseBuf))
-                    bufLen++;
-            
-                lastBit = !lastBit;
-                pulseLen = 1;
-            }
-            else {
-                pulseLen++;
-                if ((pulseLen > SEPERATION_LEN) && (bufLen > 0) ) {
-                    pulseBuf[bufPos] = SEPERATION_LEN;
-
-                    // rotate ringbuffer so that seperation pulse is located at the end (bufLen)
-                    uint8_t rot = (bufPos + sizeof(pulseBuf) - bufLen + 1) % sizeof(pulseBuf);
-                    rotateBuf(rot);
-
-                    if (RcCodec::decode(pulseBuf, bufLen) == 0) {
-                        // no matching decoder found
-                        String l = F("RAW: ");
-                        for (uint8_t i=0; i<bufLen; i++)
-                            l += String(pulseBuf[i]) + ' ';
-                        ws.textAll(l);
-                    }
+        // set bits mark samples differing from the current level, leading zeros are the samples until next edge
+        uint8_t edges = lastBit ? ~buf[i] : buf[i];
+        uint8_t remaining = 8;
 
-                    bufLen = 0;
-                }
-            }
+        while (edges != 0) {
+            const uint8_t n = __builtin_clz(edges) - 24;
+            addTime(n * PULSEWIDTHUS);
+            addEdge();
+            pulseLen = PULSEWIDTHUS; // sample with the edge
+
+            // remaining samples relative to the new level
+            remaining -= n + 1;
+            edges = (uint8_t) (~edges << (n + 1)) & (uint8_t) (0xFF << (8 - remaining));
         }
+        addTime(remaining * PULSEWIDTHUS);
     }
 }
 
-void RcPulseTransceiver::rotateBuf(uint8_t pos) {
-    uint8_t next = pos;
-    uint8_t first = 0;
-    while (first != next) {
-        //swap
-        uint8_t tmp = pulseBuf[first];
-        pulseBuf[first++] = pulseBuf[next];
-        pulseBuf[next++] = tmp;
-        
-        if (next == sizeof(pulseBuf)) {
-            next = pos;
-        }
-        else if (first == pos) {
-            pos = next;
+/**
+ * @brief converts timestamped edges of continuous mode into pulses
+ * An edge resulting in a pulse shorter than MINPULSEUS is dropped together with the following
+ * edge, like a glitch between two samples in FIFO capture.
+ */
+void RcPulseTransceiver::captureEdges() {
+    const uint32_t now = micros(); // before draining, edges up to now are in the ring
+    uint32_t time;
+    bool level;
+    while (radio->getEdge(time, level)) {
+        const uint32_t len = time - lastEdgeTime;
+        if ( (level == lastBit) || (len < MINPULSEUS) )
+            continue;
+
+        extendPulse(len);
+        addEdge();
+        lastEdgeTime = time;
+    }
+
+    // no edges during gaps, running pulse is extended by the time passed
+    if ((int32_t) (now - lastEdgeTime) > 0)
+        extendPulse(now - lastEdgeTime);
+}
+
+/**
+ * @brief extends running pulse to a total length of us
+ */
+void RcPulseTransceiver::extendPulse(const uint32_t us) {
+    if (us > pulseLen)
+        addTime(us - pulseLen);
+}
+
+/**
+ * @brief stores running pulse in ringbuffer, a new pulse with the opposite level starts
+ */
+void RcPulseTransceiver::addEdge() {
+    const Pulse pulse = pulseLen < 0xFFFF ? pulseLen : 0xFFFF;
+    pulseBuf[bufPos++] = pulse;
+    if (bufPos == PULSEBUFSIZE)
+        bufPos = 0;
+    if (bufLen < PULSEBUFSIZE)
+        bufLen++;
+    RcCodec::addPulse(pulse);
+
+    lastBit = !lastBit;
+    pulseLen = 0;
+}
+
+/**
+ * @brief extends running pulse by us without edge
+ */
+void RcPulseTransceiver::addTime(const uint32_t us) {
+    if (us == 0)
+        return;
+
+    pulseLen += us;
+    if (pulseLen > 0xFFFF)
+        pulseLen = 0xFFFF;
+
+    if (!lastBit && (pulseLen >= RcCodec::getStreamGap()) && (bufLen > 0) ) {
+        // trailing gap of a frame is running, decode without waiting for the seperation gap
+        RcCodec::decodeStream(frameView());
+    }
+
+    if ((pulseLen > SEPERATIONUS) && (bufLen > 0) ) {
+        const PulseView frame = frameView();
+
+        if (RcCodec::decode(frame) == 0) {
+            // no matching decoder found
+            String l = F("RAW: ");
+            for (uint8_t i=0; i<frame.length(); i++)
+                l += String(frame[i]) + ' ';
+            ws.textAll(l);
         }
+
+        bufLen = 0;
     }
 }
 
+/**
+ * @brief stores the running pulse at the current position and returns a view on the last bufLen pulses
+ * of the ringbuffer with the running pulse at the end
+ */
+PulseView RcPulseTransceiver::frameView() {
+    pulseBuf[bufPos] = pulseLen;
+
+    const uint8_t start = (bufPos + PULSEBUFSIZE - bufLen + 1) % PULSEBUFSIZE;
+    return PulseView(pulseBuf, PULSEBUFSIZE, start, bufLen);
+}
+
 bool RcPulseTransceiver::canHandle(AsyncWebServerRequest *request __attribute__((unused))) {
     if (request->url().startsWith(F("/send")))
         return true;
@@ -163,13 +222,13 @@ void RcPulseTransceiver::handleRequest(AsyncWebServerRequest *request __attribut
             payload = payload.substring(i + 1, -1);
         }
 
-        RcCodec* codec = RcCodec::encode(path, payload, pulseBuf, bufLen);
-        if (codec) {
-            sendPulseBuf(*codec);
+        RcCodec* codec = RcCodec::encode(path, payload);
+        if (codec == nullptr)
+            request->send(400, F("text/plain"), F("parameter error"));
+        else if (queueFrame(*codec))
             request->send(200);
-        }
         else
-            request->send(400, F("text/plain"), F("parameter error"));
+            request->send(503, F("text/plain"), F("tx queue full"));
     }
 }
 
@@ -183,13 +242,13 @@ void RcPulseTransceiver::handleBody(AsyncWebServerRequest *request __attribute__
     if (tmp.length() == total) {
         JsonDocument doc;
         if (deserializeJson(doc, tmp) == DeserializationError::Ok) {
-            RcCodec *codec = RcCodec::encode(doc.as<JsonObject>(), pulseBuf, bufLen);
-            if (codec) {
-                sendPulseBuf(*codec);
+            RcCodec *codec = RcCodec::encode(doc.as<JsonObject>());
+            if (codec == nullptr)
+                request->send(400, F("text/plain"), F("parameter error"));
+            else if (queueFrame(*codec))
                 request->send(200);
-            }
             else
-                request->send(400, F("text/plain"), F("parameter error"));
+                request->send(503, F("text/plain"), F("tx queue full"));
         }
         else
             request->send(400, F("text/plain"), F("parse error"));
@@ -202,23 +261,175 @@ void RcPulseTransceiver::onMqttMessage(const String topic, const String payload)
     RcCodec* codec = nullptr;
 
     if (topic.substring(topic.length() - 4, -1).compareTo(F("/set")) == 0) {
-        codec = RcCodec::encode(topic, payload, pulseBuf, bufLen);
+        codec = RcCodec::encode(topic, payload);
     }
     else if (topic.compareTo(F("send")) == 0) {
         JsonDocument doc;
         if (deserializeJson(doc, payload) == DeserializationError::Ok)
-            codec = RcCodec::encode(doc.as<JsonObject>(), pulseBuf, bufLen);
+            codec = RcCodec::encode(doc.as<JsonObject>());
     }
 
     if (codec)
-        sendPulseBuf(*codec);
+        queueFrame(*codec);
+}
+
+/**
+ * @brief renders the encoded pulses in pulseBuf plus footer into txChips, one bit per sample
+ * Edges are placed at the sample nearest to their time from the start of the frame, so rounding
+ * errors of single pulses don't add up.
+ * 
+ * @return false if frame doesn't fit into txChips
+ */
+bool RcPulseTransceiver::renderChips(const uint8_t len) {
+    memset(txChips, 0, sizeof(txChips));
+    txNumChips = 0;
+
+    uint32_t time = 0;
+    bool level = true;
+    for (uint8_t i=0; i<=len + 1; i++) {
+        if (i < len)
+            time += pulseBuf[i];
+        else
+            time += i == len ? TXFOOTER_HIGH : TXFOOTER_LOW;
+
+        const uint32_t end = (time + PULSEWIDTHUS / 2) / PULSEWIDTHUS;
+        if (end > sizeof(txChips) * 8)
+            return false;
+
+        if (level) {
+            for (uint16_t c=txNumChips; c<end; c++)
+                txChips[c / 8] |= 0x80 >> (c % 8);
+        }
+        txNumChips = end;
+        level = !level;
+    }
+    return true;
+}
+
+/**
+ * @brief next 8 chips of rendered frames
+ * After the last chip, the byte is filled with low chips and txMode changes to TX_DRAIN.
+ */
+uint8_t RcPulseTransceiver::nextTxByte() {
+    if (txChipPos + 8 <= txNumChips) {
+        // byte within the frame
+        const uint8_t *p = &txChips[txChipPos / 8];
+        const uint8_t shift = txChipPos % 8;
+        uint8_t result = p[0] << shift;
+        if (shift > 0)
+            result |= p[1] >> (8 - shift);
+
+        txChipPos += 8;
+        if ( (txChipPos == txNumChips) && !nextFrame() )
+            txMode = TX_DRAIN;
+        return result;
+    }
+
+    // byte crossing the end of the frame
+    uint8_t result = 0;
+    for (uint8_t mask=0x80; mask>0; mask >>= 1) {
+        if ( (txChipPos == txNumChips) && !nextFrame() ) {
+            txMode = TX_DRAIN;
+            break;
+        }
+        if ( (txChips[txChipPos / 8] & (0x80 >> (txChipPos % 8))) != 0 )
+            result |= mask;
+        txChipPos++;
+    }
+    return result;
+}
+
+/**
+ * @brief selects the next frame to send and renders it into txChips
+ * Queued commands are sent round robin, TXFRAMESPERTURN frames in a row, so repeats of
+ * several commands are interleaved. Pulses are encoded in pulseBuf, capturing is paused while sending.
+ * 
+ * @return false if queue is empty
+ */
+bool RcPulseTransceiver::nextFrame() {
+    txChipPos = 0;
+
+    // rendered chips are still valid if current command continues
+    const TxFrame &current = txQueue[txSlot];
+    if ( (current.codec == nullptr) || !current.started || (txTurnFrames >= TXFRAMESPERTURN) ) {
+        while (true) {
+            if (txQueueLen == 0)
+                return false;
+
+            do {
+                txSlot = (txSlot + 1) % TXQUEUESIZE;
+            } while (txQueue[txSlot].codec == nullptr);
+
+            TxFrame &frame = txQueue[txSlot];
+            uint8_t len = frame.codec->encodeFrame(frame.symbols, frame.numSymbols, pulseBuf);
+            if (renderChips(len))
+                break;
+
+            ws.textAll(F("TX frame too long: ") + String(FPSTR(frame.codec->getName())));
+            frame.codec = nullptr;
+            txQueueLen--;
+        }
+        txTurnFrames = 0;
+    }
+
+    TxFrame &frame = txQueue[txSlot];
+    if (!frame.started) {
+        frame.started = true;
+        txLatencyLast = millis() - frame.queued;
+        if (txLatencyLast > txLatencyMax)
+            txLatencyMax = txLatencyLast;
+    }
+
+    txTurnFrames++;
+    if (--frame.repeats == 0) {
+        // last frame of command, entry is free again
+        frame.codec = nullptr;
+        txQueueLen--;
+        txSent++;
+    }
+    return true;
+}
+
+/**
+ * @brief queues encoded symbols of codec for transmission
+ * 
+ * @return false if queue is full
+ */
+bool RcPulseTransceiver::queueFrame(RcCodec& codec) {
+    if (txQueueLen == TXQUEUESIZE) {
+        txRejected++;
+        return false;
+    }
+
+    uint8_t i = 0;
+    while (txQueue[i].codec != nullptr)
+        i++;
+
+    TxFrame &frame = txQueue[i];
+    frame.codec = &codec;
+    memcpy(frame.symbols, RcCodec::symbolBuf, RcCodec::symbolBufLen);
+    frame.numSymbols = RcCodec::symbolBufLen;
+    frame.repeats = codec.getTxRepeats() + 1;
+    frame.queued = millis();
+    frame.started = false;
+    txQueueLen++;
+    if (txQueueLen > txQueueMax)
+        txQueueMax = txQueueLen;
+
+    if ( (txMode == TX_IDLE) && nextFrame() ) {
+        txMode = TX_CHIPS;
+        radio->send(nullptr, 0, false); // start transmitting packet with unlimited length
+    }
+    return true;
 }
 
-void RcPulseTransceiver::sendPulseBuf(RcCodec& codec) {
-    txMode = TX_SYMBOLS;
-    lastBit = true;
-    txRepeats = codec.getTxRepeats();
-    bufPos = 0;
-    pulseLen = pulseBuf[bufPos++];
-    rfm69->send(nullptr, 0, false); // start transmitting packet with unlimited length
+void RcPulseTransceiver::getStatus(JsonObject &obj) {
+    JsonObject jTx = obj[F("txQueue")].to<JsonObject>();
+    jTx[F("depth")] = txQueueLen;
+    jTx[F("maxDepth")] = txQueueMax;
+    jTx[F("latencyLast")] = txLatencyLast;
+    jTx[F("latencyMax")] = txLatencyMax;
+    jTx[F("sent")] = txSent;
+    jTx[F("rejected")] = txRejected;
+    RcCodec::getStatus(obj);
 }
@@ -2,27 +2,66 @@
 #include "../radioapplication.h"
 #include "rccodecs.h"
 
+const uint8_t TXQUEUESIZE = 16;
+const uint8_t PULSEBUFSIZE = 200;
+
+/**
+ * @brief how received OOK is turned into pulses
+ */
+enum RcCapture : uint8_t {
+    RCCAPTURE_FIFO = 0, // packet mode, FIFO holds one bit per sample of PULSEWIDTHUS
+    RCCAPTURE_EDGES = 1 // continuous mode, edges on DIO2 are timestamped by interrupt
+};
+
 class RcPulseTransceiver: public RadioApplication {
 private:
-    uint8_t pulseBuf[200];
+    Pulse pulseBuf[PULSEBUFSIZE];
     uint8_t bufPos;
     uint8_t bufLen;
     bool lastBit;
-    uint16_t pulseLen;
+    uint32_t pulseLen; // running pulse / µS
+    bool edgeCapture;
+    uint32_t lastEdgeTime; // micros() of the last edge in edge capture
     enum TxMode {
         TX_IDLE,
-        TX_SYMBOLS,
-        TX_FOOTER1,
-        TX_FOOTER2
+        TX_CHIPS,
+        TX_DRAIN
     } txMode;
-    uint8_t txRepeats;
-    void rotateBuf(uint8_t pos);
+    struct TxFrame {
+        RcCodec *codec; // nullptr: free entry
+        uint8_t symbols[SYMBOLBUFSIZE];
+        uint8_t numSymbols;
+        uint8_t repeats; // frames left to send
+        uint32_t queued; // millis() when queued
+        bool started;
+    } txQueue[TXQUEUESIZE];
+    uint8_t txQueueLen;
+    uint8_t txSlot; // entry in txQueue currently sent
+    uint8_t txTurnFrames; // frames of current entry sent in a row
+    uint8_t txQueueMax;
+    uint32_t txLatencyLast;
+    uint32_t txLatencyMax;
+    uint32_t txSent;
+    uint32_t txRejected;
+    uint8_t txChips[256]; // rendered frame incl. footer, one bit per sample
+    uint16_t txNumChips;
+    uint16_t txChipPos;
+    bool renderChips(const uint8_t len);
+    bool nextFrame();
+    uint8_t nextTxByte();
+    PulseView frameView();
+    void addEdge();
+    void addTime(const uint32_t us);
+    void extendPulse(const uint32_t us);
+    void startCapture();
+    void captureEdges();
     bool canHandle(AsyncWebServerRequest *request __attribute__((unused)));
     void handleRequest(AsyncWebServerRequest *request __attribute__((unused)));
     void handleBody(AsyncWebServerRequest *request __attribute__((unused)), uint8_t *data __attribute__((unused)), size_t len __attribute__((unused)), size_t index __attribute__((unused)), size_t total __attribute__((unused)));
 public:
-    RcPulseTransceiver();
+    RcPulseTransceiver(RfmBase *radio, const RcCapture capture = RCCAPTURE_FIFO);
     void loop();
     void onMqttMessage(const String topic, const String payload);
-    void sendPulseBuf(RcCodec &codec);
+    void getStatus(JsonObject &obj);
+    bool queueFrame(RcCodec &codec);
 };
\ No newline at end of file
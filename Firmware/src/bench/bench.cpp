@@ -0,0 +1,771 @@
+/**
+ * @brief host benchmark of the RC codecs and the 868 MHz decoders
+ * Build and run with: pio run -e native -t exec
+ * Recorded pulse trains and payloads are fed through the applications' loop() like the radio
+ * would deliver them, time and heap allocations per frame are reported for every decoder.
+ */
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "applications/rc433.h"
+#include "applications/868gw.h"
+#include "applications/checksum.h"
+#include "applications/ec3kframe.h"
+#include "fakerfm.h"
+#include "recordings.h"
+
+PubSubClient mqtt;
+AsyncWebSocket ws;
+String baseTopic = F("gw");
+static RfmBase *radio;
+AsyncWebServer websrv;
+
+static uint32_t allocations = 0;
+
+#ifdef __GLIBC__
+// count every heap allocation, including those of std::string (String) and ArduinoJson
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+extern "C" void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+    allocations++;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+const uint32_t FRAMES = 20000; // frames per decoder
+const uint8_t RCLEADINGGAP = 130; // samples of silence in front of a pulse train
+const uint16_t FSKNOISESAMPLES = 1280; // 20 ms of receiver noise in front of a sampled frame
+const uint8_t ESP8266SLOWDOWN = 50; // assumed ratio of a desktop core to the ESP8266 at 80 MHz, not measured
+
+struct BenchResult {
+    double nsPerFrame;
+    double allocsPerFrame;
+    double publishesPerFrame;
+};
+
+static void printResult(const char *name, const BenchResult &r) {
+    printf("%-18s %10.0f %14.2f %12.2f\n", name, r.nsPerFrame, r.allocsPerFrame, r.publishesPerFrame);
+}
+
+/**
+ * @brief converts a pulse train to the chips the RFM69 delivers in OOK continuous RX
+ */
+static std::vector<uint8_t> renderChips(const uint8_t *pulses, const size_t len) {
+    std::vector<uint8_t> chips;
+    uint8_t byte = 0;
+    uint8_t bits = 0;
+    auto addSamples = [&](const bool level, uint8_t n) {
+        while (n-- > 0) {
+            byte = byte << 1 | level;
+            if (++bits == 8) {
+                chips.push_back(byte);
+                bits = 0;
+            }
+        }
+    };
+
+    addSamples(false, RCLEADINGGAP);
+    for (size_t i=0; i<len; i++)
+        addSamples((i % 2) == 0, pulses[i]);
+    while (bits != 0)
+        addSamples(false, 1);
+    return chips;
+}
+
+/**
+ * @brief converts a pulse train to edge timestamps like RfmBase captures them in continuous RX
+ * The last edge is at micros() when the frame is loaded.
+ */
+static std::vector<uint32_t> renderEdges(const uint8_t *pulses, const size_t len) {
+    uint32_t duration = 0;
+    for (size_t i=0; i<len; i++)
+        duration += pulses[i] * PULSEWIDTHUS;
+
+    std::vector<uint32_t> edges;
+    uint32_t t = -duration;
+    for (size_t i=0; i<len; i++) {
+        edges.push_back((t & ~1UL) | ((i % 2) == 0)); // high pulses at even indices
+        t += pulses[i] * PULSEWIDTHUS;
+    }
+    edges.push_back(t & ~1UL); // end of last pulse
+    return edges;
+}
+
+/**
+ * @brief samples a frame at FSKSAMPLERATE like the RFM69 delivers it in Gw868's sample capture
+ * Preamble, sync word and payload at the frame's bitrate follow FSKNOISESAMPLES of noise.
+ */
+static std::vector<uint8_t> renderSamples(const uint8_t *sync, const uint8_t syncLen, const uint8_t *payload, const size_t len, const uint16_t bitrate) {
+    std::vector<uint8_t> frame(4, 0xAA); // preamble
+    frame.insert(frame.end(), sync, sync + syncLen);
+    frame.insert(frame.end(), payload, payload + len);
+    frame.push_back(0); // trailer
+
+    std::vector<uint8_t> samples;
+    uint8_t byte = 0;
+    uint8_t bits = 0;
+    auto addSample = [&](const bool level) {
+        byte = byte << 1 | level;
+        if (++bits == 8) {
+            samples.push_back(byte);
+            bits = 0;
+        }
+    };
+
+    uint16_t noise = 0xACE1;
+    for (uint16_t i=0; i<FSKNOISESAMPLES; i++) {
+        noise = (noise >> 1) ^ (-(noise & 1) & 0xB400);
+        addSample(noise & 1);
+    }
+    const uint32_t numSamples = (uint64_t) frame.size() * 8 * FSKSAMPLERATE / bitrate;
+    for (uint32_t i=0; i<numSamples; i++) {
+        const uint32_t bit = (uint64_t) i * bitrate / FSKSAMPLERATE;
+        addSample((frame[bit >> 3] >> (7 - (bit & 7))) & 1);
+    }
+    while (bits != 0)
+        addSample(false);
+    return samples;
+}
+
+/**
+ * @brief feeds a recorded frame FRAMES times through the application's loop()
+ * Repeat suppression is bypassed by skipping time between frames, so every frame is published.
+ * 
+ * @param edges true: data are edges of renderEdges(), len is the number of edges
+ */
+static BenchResult runFrames(RadioApplication &app, const void *data, const size_t len, const bool edges = false) {
+    const uint32_t allocsStart = allocations;
+    const uint32_t publishedStart = mqtt.published;
+    std::chrono::nanoseconds elapsed(0);
+    std::vector<uint32_t> frameEdges(edges ? len : 0);
+
+    for (uint32_t i=0; i<FRAMES; i++) {
+        delay(REPEATTIMEOUT);
+        if (edges) {
+            const uint32_t now = micros();
+            for (size_t e=0; e<len; e++)
+                frameEdges[e] = ((const uint32_t *) data)[e] + (now & ~1UL);
+            fakeRfmLoadEdges(frameEdges.data(), len);
+        }
+        else
+            fakeRfmLoad((const uint8_t *) data, len);
+        const auto t0 = std::chrono::steady_clock::now();
+        while (fakeRfmRxPending())
+            app.loop();
+        elapsed += std::chrono::steady_clock::now() - t0;
+    }
+
+    BenchResult r;
+    r.nsPerFrame = (double) elapsed.count() / FRAMES;
+    r.allocsPerFrame = (double) (allocations - allocsStart) / FRAMES;
+    r.publishesPerFrame = (double) (mqtt.published - publishedStart) / FRAMES;
+    return r;
+}
+
+static void benchRc() {
+    static const struct {
+        const char *name;
+        const uint8_t *pulses;
+        size_t len;
+    } RECORDINGS[] = {
+        {"ittristate", PULSES_ITTRISTATE, sizeof(PULSES_ITTRISTATE)},
+        {"intertechno", PULSES_INTERTECHNO, sizeof(PULSES_INTERTECHNO)},
+        {"EV1527", PULSES_EV1527, sizeof(PULSES_EV1527)},
+        {"emylo", PULSES_EMYLO, sizeof(PULSES_EMYLO)},
+        {"noise", PULSES_NOISE, sizeof(PULSES_NOISE)},
+    };
+
+    JsonDocument conf;
+    Rc433Transceiver *app = new Rc433Transceiver(radio, conf.to<JsonObject>());
+    for (auto &rec : RECORDINGS) {
+        const std::vector<uint8_t> chips = renderChips(rec.pulses, rec.len);
+        printResult(rec.name, runFrames(*app, chips.data(), chips.size()));
+    }
+    delete app;
+
+    // same recordings captured as edges on DIO2
+    conf[F("capture")] = RCCAPTURE_EDGES;
+    app = new Rc433Transceiver(radio, conf.as<JsonObject>());
+    for (auto &rec : RECORDINGS) {
+        const std::vector<uint32_t> edges = renderEdges(rec.pulses, rec.len);
+        const String name = String(rec.name) + F("/edges");
+        printResult(name.c_str(), runFrames(*app, edges.data(), edges.size(), true));
+    }
+    delete app;
+}
+
+/**
+ * @brief a codec's matching on a complete pulse train, with its cached or flash matching tables
+ * and as it was before: windows calculated into allocated tables for every pulse train
+ */
+template<class Codec>
+class MatchBench: public Codec {
+public:
+    bool match(const PulseView &pulses) {
+        return this->RcCodec::decodePulses(pulses);
+    }
+
+    bool matchUncached(const PulseView &pulses) {
+        const RcCodec::CodecParams p = this->getParams();
+        const uint8_t frameLen = p.numSymbols * p.pulsesPerSymbol + 2;
+        if (pulses.length() < frameLen)
+            return false;
+        const PulseView ppb = pulses.sub(pulses.length() - frameLen, frameLen);
+
+        uint16_t timebase = p.timebase;
+        if (p.numSymbolsAutoTimebase > 0) {
+            uint32_t sumPulses = 0;
+            for (uint8_t i=0; i<p.numSymbolsAutoTimebase * p.pulsesPerSymbol; i++)
+                sumPulses += ppb[i];
+            uint8_t symDur = 0;
+            for (uint8_t i=0; i<p.pulsesPerSymbol; i++)
+                symDur += p.symbolTable[i];
+            timebase = sumPulses / p.numSymbolsAutoTimebase / symDur;
+            if ( (timebase < p.timebase_min) || (timebase > p.timebase_max) )
+                return false;
+        }
+
+        const uint8_t n = p.numTableSymbols * p.pulsesPerSymbol;
+        Pulse *symTabLow = (Pulse *) malloc(n * sizeof(Pulse));
+        Pulse *symTabHigh = (Pulse *) malloc(n * sizeof(Pulse));
+        for (uint8_t i=0; i<n; i++) {
+            symTabLow[i] = RcCodec::matchLow(timebase, p.symbolTable[i], p.qDecode, PULSEWIDTHUS);
+            symTabHigh[i] = RcCodec::matchHigh(timebase, p.symbolTable[i], p.qDecode, PULSEWIDTHUS);
+        }
+
+        uint8_t bp = 0;
+        RcCodec::symbolBufLen = 0;
+        while (bp + p.pulsesPerSymbol <= frameLen) {
+            uint8_t s;
+            for (s=0; s<p.numTableSymbols; s++) {
+                uint8_t i;
+                for (i=0; i<p.pulsesPerSymbol; i++) {
+                    const uint8_t ist = s * p.pulsesPerSymbol + i;
+                    if ( (bp + i != 0) && ((ppb[bp + i] < symTabLow[ist]) || (ppb[bp + i] > symTabHigh[ist])) )
+                        break;
+                }
+                if (i == p.pulsesPerSymbol)
+                    break;
+            }
+            if (s == p.numTableSymbols)
+                break;
+            RcCodec::symbolBuf[RcCodec::symbolBufLen++] = s;
+            bp += p.pulsesPerSymbol;
+        }
+
+        free(symTabLow);
+        free(symTabHigh);
+        return (p.numSymbols == bp / p.pulsesPerSymbol);
+    }
+};
+
+/**
+ * @brief times the matching of each codec on its recorded pulse train, before and after the
+ * matching tables were kept per codec, and checks that both decode the same symbols
+ * FS20 has a fixed timebase, its tables are built at compile time. Its train is synthesized from
+ * the symbol table, there is no recording.
+ */
+static void benchMatching() {
+    RcCodec::setResolution(PULSEWIDTHUS);
+    MatchBench<ITTristate> itTristate;
+    MatchBench<IT32> it32;
+    MatchBench<EV1527Codec> ev1527;
+    MatchBench<FS20Codec> fs20;
+
+    std::vector<uint8_t> fs20Pulses;
+    for (uint8_t i=0; i<115; i++)
+        fs20Pulses.push_back((((i / 2) * 7) % 3 == 0) ? 12 : 8); // symbols 1 and 0 at 200 µs timebase, aligned to the footer
+    fs20Pulses.push_back(150);
+
+    struct Entry {
+        const char *name;
+        const uint8_t *pulses;
+        size_t len;
+        std::function<bool(const PulseView &)> match;
+        std::function<bool(const PulseView &)> matchUncached;
+    };
+    auto entry = [](const char *name, const uint8_t *pulses, const size_t len, auto &codec) {
+        return Entry{name, pulses, len,
+            [&codec](const PulseView &v) { return codec.match(v); },
+            [&codec](const PulseView &v) { return codec.matchUncached(v); }};
+    };
+    const Entry ENTRIES[] = {
+        entry("ittristate", PULSES_ITTRISTATE, sizeof(PULSES_ITTRISTATE), itTristate),
+        entry("intertechno", PULSES_INTERTECHNO, sizeof(PULSES_INTERTECHNO), it32),
+        entry("EV1527", PULSES_EV1527, sizeof(PULSES_EV1527), ev1527),
+        entry("emylo", PULSES_EMYLO, sizeof(PULSES_EMYLO), ev1527),
+        entry("noise", PULSES_NOISE, sizeof(PULSES_NOISE), ev1527),
+        entry("FS20", fs20Pulses.data(), fs20Pulses.size(), fs20),
+    };
+
+    printf("\n%-18s %10s %12s %14s\n", "matching", "ns/train", "uncached ns", "allocs/train");
+    for (auto &e : ENTRIES) {
+        std::vector<Pulse> pulses;
+        for (size_t i=0; i<e.len; i++)
+            pulses.push_back(e.pulses[i] * PULSEWIDTHUS);
+        const PulseView view(pulses.data(), pulses.size());
+
+        const bool decoded = e.match(view);
+        const std::vector<uint8_t> symbols(RcCodec::symbolBuf, RcCodec::symbolBuf + RcCodec::symbolBufLen);
+        const bool same = (e.matchUncached(view) == decoded) &&
+            (symbols == std::vector<uint8_t>(RcCodec::symbolBuf, RcCodec::symbolBuf + RcCodec::symbolBufLen));
+
+        volatile uint32_t sink = 0; // keeps the results alive
+        auto time = [&](const std::function<bool(const PulseView &)> &fn) {
+            const auto t0 = std::chrono::steady_clock::now();
+            for (uint32_t i=0; i<FRAMES; i++)
+                sink += fn(view);
+            return (double) std::chrono::nanoseconds(std::chrono::steady_clock::now() - t0).count() / FRAMES;
+        };
+        const double ns = time(e.match);
+        const uint32_t allocsStart = allocations;
+        const double nsUncached = time(e.matchUncached);
+        printf("%-18s %10.1f %12.1f %14.2f   %s%s\n", e.name, ns, nsUncached, (double) (allocations - allocsStart) / FRAMES,
+            decoded ? "decoded" : "no frame", same ? "" : ", symbols DIFFER");
+    }
+}
+
+/**
+ * @brief pulses extracted from the samples of FIFO capture, reduced to a count and a hash of
+ * their lengths
+ */
+struct PulseSink {
+    bool level = false;
+    uint32_t pulseLen = 0; // samples
+    uint32_t pulses = 0;
+    uint32_t hash = 0;
+
+    void edge() {
+        hash = hash * 31 + pulseLen;
+        pulses++;
+        level = !level;
+        pulseLen = 1; // sample with the edge
+    }
+};
+
+/**
+ * @brief the former extraction of RcPulseTransceiver::loop(), sample by sample
+ */
+static void extractBitwise(PulseSink &sink, const uint8_t *buf, const size_t len) {
+    for (size_t i=0; i<len; i++) {
+        for (uint8_t mask=0x80; mask > 0; mask >>= 1) {
+            if ( ((buf[i] & mask) != 0) != sink.level )
+                sink.edge();
+            else
+                sink.pulseLen++;
+        }
+    }
+}
+
+/**
+ * @brief extraction by runs as in RcPulseTransceiver::loop()
+ */
+static void extractRuns(PulseSink &sink, const uint8_t *buf, const size_t len) {
+    for (size_t i=0; i<len; i++) {
+        uint8_t edges = sink.level ? ~buf[i] : buf[i];
+        uint8_t remaining = 8;
+
+        while (edges != 0) {
+            const uint8_t n = __builtin_clz(edges) - 24;
+            sink.pulseLen += n;
+            sink.edge();
+            remaining -= n + 1;
+            edges = (uint8_t) (~edges << (n + 1)) & (uint8_t) (0xFF << (8 - remaining));
+        }
+        sink.pulseLen += remaining;
+    }
+}
+
+/**
+ * @brief compares both extractions of FIFO capture on the recorded pulse trains and idle air,
+ * then measures their throughput
+ */
+static void benchFifoExtraction() {
+    static const struct {
+        const char *name;
+        const uint8_t *pulses;
+        size_t len;
+    } RECORDINGS[] = {
+        {"ittristate", PULSES_ITTRISTATE, sizeof(PULSES_ITTRISTATE)},
+        {"intertechno", PULSES_INTERTECHNO, sizeof(PULSES_INTERTECHNO)},
+        {"EV1527", PULSES_EV1527, sizeof(PULSES_EV1527)},
+        {"emylo", PULSES_EMYLO, sizeof(PULSES_EMYLO)},
+        {"noise", PULSES_NOISE, sizeof(PULSES_NOISE)},
+        {"idle", nullptr, 0},
+    };
+
+    printf("\n%-18s %10s %12s\n", "FIFO extraction", "bytes/us", "bitwise");
+    for (auto &rec : RECORDINGS) {
+        const std::vector<uint8_t> chips = (rec.pulses != nullptr) ? renderChips(rec.pulses, rec.len) : std::vector<uint8_t>(1024, 0);
+
+        PulseSink runs;
+        PulseSink bitwise;
+        extractRuns(runs, chips.data(), chips.size());
+        extractBitwise(bitwise, chips.data(), chips.size());
+        const bool same = (runs.pulses == bitwise.pulses) && (runs.hash == bitwise.hash) &&
+            (runs.pulseLen == bitwise.pulseLen);
+
+        auto rate = [&](void (*extract)(PulseSink &, const uint8_t *, const size_t)) {
+            const uint32_t rounds = 2000000 / chips.size() + 1;
+            PulseSink sink;
+            const auto t0 = std::chrono::steady_clock::now();
+            for (uint32_t i=0; i<rounds; i++)
+                extract(sink, chips.data(), chips.size());
+            const double ns = std::chrono::nanoseconds(std::chrono::steady_clock::now() - t0).count();
+            volatile uint32_t keep = sink.hash; // keeps the result alive
+            (void) keep;
+            return (double) chips.size() * rounds / ns * 1000;
+        };
+        printf("%-18s %10.1f %12.1f   %s\n", rec.name, rate(extractRuns), rate(extractBitwise),
+            same ? "same pulses" : "pulses DIFFER");
+    }
+}
+
+static void bench868() {
+    static const struct {
+        const char *name;
+        uint8_t rxMode; // bit of the decoder in rxmodes
+        const uint8_t *payload;
+        size_t len;
+    } RECORDINGS[] = {
+        {"LaCrosse", 0, PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE)},
+        {"EC3K", 3, PAYLOAD_EC3K, sizeof(PAYLOAD_EC3K)},
+        {"Bresser7in1", 4, PAYLOAD_BRESSER, sizeof(PAYLOAD_BRESSER)},
+        {"EMT7170", 5, PAYLOAD_EMT7170, sizeof(PAYLOAD_EMT7170)},
+    };
+
+    printf("\n%-18s %10s %14s %12s\n", "868 MHz decoder", "ns/frame", "allocs/frame", "pubs/frame");
+    for (auto &rec : RECORDINGS) {
+        JsonDocument conf;
+        conf[F("rxmodes")] = 1 << rec.rxMode;
+        conf[F("interval")] = 1000000; // no mode switching during the benchmark
+        Gw868 *app = new Gw868(radio, conf.as<JsonObject>());
+        app->loop(); // switch to rxMode
+        printResult(rec.name, runFrames(*app, rec.payload, rec.len));
+        delete app;
+    }
+}
+
+/**
+ * @brief all modes demodulated at once from samples, load is the share of the frame's air time
+ * the host needs
+ * The ESP8266 column only scales that by ESP8266SLOWDOWN, it is a guess and proves nothing about
+ * the target. On the ESP8266 the status of the application tells fifoReadGapMax, and the radio's
+ * fifoOverruns count what the deadline of about 8 ms for a full FIFO cost.
+ */
+static void benchFsk() {
+    static const uint8_t SYNC2DD4[] = {0x2D, 0xD4};
+    static const uint8_t SYNCEC3K[] = {0x13, 0xF1, 0x85, 0xD3, 0xAC};
+    static const struct {
+        const char *name;
+        uint16_t bitrate; // as in Gw868's mode table
+        const uint8_t *sync;
+        uint8_t syncLen;
+        const uint8_t *payload;
+        size_t len;
+    } RECORDINGS[] = {
+        {"LaCrosse", 17241, SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE)},
+        {"EC3K", 20000, SYNCEC3K, sizeof(SYNCEC3K), PAYLOAD_EC3K, sizeof(PAYLOAD_EC3K)},
+        {"Bresser7in1", 8000, SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_BRESSER, sizeof(PAYLOAD_BRESSER)},
+        {"EMT7170", 9579, SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_EMT7170, sizeof(PAYLOAD_EMT7170)},
+        {"noise", 9579, SYNC2DD4, 0, nullptr, 0},
+    };
+
+    printf("\n%-18s %10s %14s %12s %8s %10s\n", "all modes", "ns/frame", "allocs/frame", "pubs/frame", "load %", "ESP est %");
+    JsonDocument conf;
+    conf[F("rxmodes")] = 0x3F;
+    conf[F("capture")] = GW868CAPTURE_SAMPLES;
+    Gw868 *app = new Gw868(radio, conf.as<JsonObject>());
+    for (auto &rec : RECORDINGS) {
+        const std::vector<uint8_t> samples = renderSamples(rec.sync, rec.syncLen, rec.payload, rec.len, rec.bitrate);
+        const BenchResult r = runFrames(*app, samples.data(), samples.size());
+        const double load = r.nsPerFrame / (samples.size() * 8 * 1e9 / FSKSAMPLERATE) * 100;
+        printf("%-18s %10.0f %14.2f %12.2f %8.2f %10.1f\n", rec.name, r.nsPerFrame, r.allocsPerFrame,
+            r.publishesPerFrame, load, load * ESP8266SLOWDOWN);
+    }
+
+    // every frame is handed to the decoders of the receive mode it was sent in, TX22 also syncs on
+    // the Bresser7in1 and EMT7170 frames, it has no decoder yet and counts them as frames only
+    JsonDocument doc;
+    JsonObject status = doc.to<JsonObject>();
+    app->getStatus(status);
+    JsonArray decoders = status[F("decoders")].as<JsonArray>();
+    printf("\n%-18s %10s %14s %12s %12s %12s\n", "decoder stats", "frames", "checksum err", "false syncs", "decoded", "us/frame");
+    for (size_t i=0; i<decoders.size(); i++) {
+        JsonVariant d = decoders[i];
+        const uint32_t frames = d[F("frames")] | 0;
+        printf("%-18s %10lu %14lu %12lu %12lu %12.2f\n", d[F("name")].as<const char *>(), (unsigned long) frames,
+            (unsigned long) (d[F("checksumErrors")] | 0), (unsigned long) (d[F("falseSyncs")] | 0), (unsigned long) (d[F("decoded")] | 0),
+            (frames != 0) ? (double) (d[F("cpuTime")] | 0) / frames : 0.0);
+    }
+    delete app;
+}
+
+/**
+ * @brief bit by bit reference implementations of checksum.h, as the decoders had them
+ */
+static uint8_t crc8Bitwise(const uint8_t *buf, const size_t len) {
+    uint8_t crc = 0;
+    for (size_t i=0; i<len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b=0; b<8; b++)
+            crc = ((crc & 0x80) != 0) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+static uint16_t crcCcittBitwise(const uint8_t *buf, const size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i=0; i<len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b=0; b<8; b++)
+            crc = ((crc & 1) != 0) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+    }
+    return crc;
+}
+
+static uint16_t bresserDigestBitwise(const uint8_t *buf, const size_t len) {
+    uint16_t sum = 0;
+    uint16_t k = 0xBA95;
+    for (size_t i=0; i<len; i++) {
+        for (int8_t b=7; b>=0; b--) {
+            if (((buf[i] >> b) & 1) != 0)
+                sum ^= k;
+            k = ((k & 1) != 0) ? (k >> 1) ^ 0x8810 : k >> 1;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief checks checksum.h against the recorded frames and the reference implementations on
+ * random data, then times both on the frames
+ */
+static void benchChecksums() {
+    uint8_t bresser[sizeof(PAYLOAD_BRESSER)];
+    for (size_t i=0; i<sizeof(bresser); i++)
+        bresser[i] = PAYLOAD_BRESSER[i] ^ 0xAA;
+    const uint16_t bresserSum = bresser[0] << 8 | bresser[1];
+
+    // residues of valid frames, as the decoders check them
+    uint8_t failed = 0;
+    failed += crc8(PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE)) != 0;
+    failed += crc8(PAYLOAD_LACROSSE, 4) != PAYLOAD_LACROSSE[4];
+    failed += crcCcitt(PAYLOAD_EC3K_HDLC, sizeof(PAYLOAD_EC3K_HDLC)) != 0xF0B8;
+    failed += (bresserDigest(&bresser[2], 23) ^ bresserSum) != 0x6DF1;
+
+    uint16_t lfsr = 0xACE1;
+    uint8_t random[64];
+    for (uint16_t n=0; n<1000; n++) {
+        const size_t len = n % sizeof(random);
+        for (size_t i=0; i<len; i++) {
+            lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB400);
+            random[i] = lfsr;
+        }
+        failed += crc8(random, len) != crc8Bitwise(random, len);
+        failed += crcCcitt(random, len) != crcCcittBitwise(random, len);
+        failed += bresserDigest(random, len) != bresserDigestBitwise(random, len);
+    }
+
+    printf("\n%-18s %10s %12s   vectors %s\n", "checksum", "ns/frame", "bitwise ns", (failed == 0) ? "ok" : "FAILED");
+    volatile uint32_t sink = 0; // keeps the results alive
+    auto time = [&](auto fn) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i=0; i<FRAMES; i++)
+            sink += fn();
+        return (double) std::chrono::nanoseconds(std::chrono::steady_clock::now() - t0).count() / FRAMES;
+    };
+    printf("%-18s %10.1f %12.1f\n", "CRC-8 LaCrosse",
+        time([] { return crc8(PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE)); }),
+        time([] { return crc8Bitwise(PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE)); }));
+    printf("%-18s %10.1f %12.1f\n", "CRC-CCITT EC3K",
+        time([] { return crcCcitt(PAYLOAD_EC3K_HDLC, sizeof(PAYLOAD_EC3K_HDLC)); }),
+        time([] { return crcCcittBitwise(PAYLOAD_EC3K_HDLC, sizeof(PAYLOAD_EC3K_HDLC)); }));
+    printf("%-18s %10.1f %12.1f\n", "digest Bresser",
+        time([&] { return bresserDigest(&bresser[2], 23); }),
+        time([&] { return bresserDigestBitwise(&bresser[2], 23); }));
+}
+
+static uint8_t parity(uint32_t v) {
+    uint8_t result = 0;
+    while (v != 0) {
+        result ^= 1;
+        v &= v - 1;
+    }
+    return result;
+}
+
+/**
+ * @brief the former bit by bit descrambler and HDLC unstuffer of the EC3K decoder, as a
+ * reference for ec3kUnframe()
+ */
+static int ec3kUnframeBitwise(uint8_t *buf, const size_t len) {
+    uint32_t lfsr = 0xF185D3AC;
+    for (size_t i=0; i<len; i++) {
+        uint8_t ob = 0;
+        for (int8_t b=7; b>=0; b--) {
+            const uint8_t inbit = (buf[i] >> b) & 1;
+            ob = ob << 1 | (inbit ^ parity(lfsr & 0x31801));
+            lfsr = lfsr << 1 | inbit;
+        }
+        buf[i] = ~ob;
+    }
+    if (buf[0] != 0x7E)
+        return -1;
+
+    uint8_t ones = 0;
+    uint8_t ob = 0;
+    uint8_t obits = 0;
+    uint8_t *po = &buf[1];
+    for (size_t i=1; i<len; i++) {
+        for (int8_t b=7; b>=0; b--) {
+            const uint8_t inbit = (buf[i] >> b) & 1;
+            if ( (ones >= 5) && (inbit == 0) ) {
+                if (ones == 6)
+                    return po - &buf[1];
+                ones = 0;
+                continue;
+            }
+            ones = inbit ? ones + 1 : 0;
+            ob = ob >> 1 | inbit << 7;
+            if (++obits == 8) {
+                obits = 0;
+                *po++ = ob;
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief builds a scrambled EC3K frame: opening flag, payload LSB first with stuffed bits,
+ * closing flag and padding, inverted and scrambled like the sensor does
+ *
+ * @return bytes used of frame
+ */
+static size_t ec3kFrame(const uint8_t *payload, const size_t len, uint8_t *frame, const size_t frameLen) {
+    std::vector<uint8_t> bits;
+    auto flag = [&] {
+        for (int8_t b=7; b>=0; b--)
+            bits.push_back((0x7E >> b) & 1);
+    };
+    flag();
+    uint8_t ones = 0;
+    for (size_t i=0; i<len; i++) {
+        for (uint8_t b=0; b<8; b++) {
+            const uint8_t bit = (payload[i] >> b) & 1;
+            bits.push_back(bit);
+            ones = bit ? ones + 1 : 0;
+            if (ones == 5) {
+                bits.push_back(0);
+                ones = 0;
+            }
+        }
+    }
+    flag();
+    while ((bits.size() % 8) != 0)
+        bits.push_back(0);
+
+    uint32_t history = 0xF185D3AC;
+    size_t n = 0;
+    for (; (n < frameLen) && (n * 8 < bits.size()); n++) {
+        uint8_t byte = 0;
+        for (uint8_t b=0; b<8; b++) {
+            const uint8_t bit = (bits[n * 8 + b] ^ 1) ^ parity(history & 0x31801);
+            history = history << 1 | bit;
+            byte = byte << 1 | bit;
+        }
+        frame[n] = byte;
+    }
+    return n;
+}
+
+/**
+ * @brief checks ec3kUnframe() against the reference on the recorded frame, on synthesized frames,
+ * some with a flipped bit, and on random data, then times both on the recorded frame
+ */
+static void benchEc3kFrame() {
+    uint8_t a[80];
+    uint8_t b[80];
+    uint8_t failed = 0;
+    auto compare = [&](const uint8_t *frame, const size_t len) {
+        memcpy(a, frame, len);
+        memcpy(b, frame, len);
+        const int la = ec3kUnframe(a, len);
+        const int lb = ec3kUnframeBitwise(b, len);
+        if ( (la != lb) || ((la > 0) && (memcmp(&a[1], &b[1], la) != 0)) )
+            failed++;
+        return la;
+    };
+
+    if (compare(PAYLOAD_EC3K, sizeof(PAYLOAD_EC3K)) != sizeof(PAYLOAD_EC3K_HDLC) ||
+            memcmp(&a[1], PAYLOAD_EC3K_HDLC, sizeof(PAYLOAD_EC3K_HDLC)) != 0)
+        failed++;
+
+    uint16_t lfsr = 0xACE1;
+    auto next = [&] {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB400);
+        return (uint8_t) lfsr;
+    };
+    uint8_t payload[48];
+    uint8_t frame[sizeof(a)];
+    uint16_t framed = 0;
+    for (uint16_t n=0; n<1000; n++) {
+        const size_t len = n % sizeof(payload);
+        for (size_t i=0; i<len; i++)
+            payload[i] = ((n & 2) != 0) ? next() | next() : next(); // many runs of 1s
+        size_t frameLen = ec3kFrame(payload, len, frame, sizeof(frame));
+        while (frameLen < sizeof(frame))
+            frame[frameLen++] = next();
+        if ((n & 1) != 0)
+            frame[1 + next() % (len + 1)] ^= 1 << (next() & 7);
+        if ((compare(frame, sizeof(frame)) == (int) len) && (memcmp(&a[1], payload, len) == 0) && ((n & 1) == 0))
+            framed++;
+
+        for (size_t i=0; i<sizeof(frame); i++)
+            frame[i] = next();
+        compare(frame, sizeof(frame));
+    }
+    failed += framed != 500;
+
+    printf("\n%-18s %10s %12s   vectors %s\n", "EC3K unframe", "ns/frame", "bitwise ns", (failed == 0) ? "ok" : "FAILED");
+    volatile int sink = 0;
+    auto time = [&](auto fn) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i=0; i<FRAMES; i++) {
+            memcpy(a, PAYLOAD_EC3K, sizeof(PAYLOAD_EC3K));
+            sink += fn(a, sizeof(PAYLOAD_EC3K));
+        }
+        return (double) std::chrono::nanoseconds(std::chrono::steady_clock::now() - t0).count() / FRAMES;
+    };
+    printf("%-18s %10.1f %12.1f\n", "descramble+unstuff", time(ec3kUnframe), time(ec3kUnframeBitwise));
+}
+
+int main() {
+    radio = new Rfm69;
+
+    printf("%-18s %10s %14s %12s\n", "decoder", "ns/frame", "allocs/frame", "pubs/frame");
+    benchRc();
+    benchFifoExtraction();
+    benchMatching();
+    bench868();
+    benchFsk();
+    benchChecksums();
+    benchEc3kFrame();
+    return 0;
+}
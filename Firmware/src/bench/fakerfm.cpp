@@ -0,0 +1,78 @@
+#include "fakerfm.h"
+#include "rfm.h"
+
+static const uint8_t *rxData = nullptr;
+static size_t rxLen = 0;
+static size_t rxPos = 0;
+static const uint32_t *edgeData = nullptr;
+static size_t edgeLen = 0;
+static size_t edgePos = 0;
+
+void fakeRfmLoad(const uint8_t *data, const size_t len) {
+    rxData = data;
+    rxLen = len;
+    rxPos = 0;
+}
+
+/**
+ * @brief edges in the format of RfmBase::edgeRing, timestamps must not be in the future
+ */
+void fakeRfmLoadEdges(const uint32_t *edges, const size_t len) {
+    edgeData = edges;
+    edgeLen = len;
+    edgePos = 0;
+}
+
+bool fakeRfmRxPending() {
+    return (rxPos < rxLen) || (edgePos < edgeLen);
+}
+
+void RfmBase::begin(const uint8_t pinSS) {}
+RfmBase::~RfmBase() {}
+Rfm69::~Rfm69() {}
+void Rfm69::begin(const uint8_t pinSS, const bool isHighPower, const uint8_t pinDio0, const uint8_t pinDio2) {}
+void Rfm69::loop() {}
+void Rfm69::stop() {}
+void Rfm69::setModulation(const Modulation modulation) {}
+void Rfm69::setRxBandwidth(const uint32_t bw_hz) {}
+void Rfm69::setRssiThreshold(const uint8_t thresh) {}
+void Rfm69::setPreamble(const uint16_t len) {}
+void Rfm69::setFifoThreshold(const uint8_t thresh) {}
+void Rfm69::setSync(const uint8_t *sync, const int syncsize) {}
+void Rfm69::setTxPower(const int8_t power) {}
+void Rfm69::setFreq(const uint32_t freq_hz) {}
+void Rfm69::setBitrate(const uint16_t bit_s) {}
+void Rfm69::send(const uint8_t *data, const int size, const bool varSize) {}
+void Rfm69::txTest(const uint32_t freq_hz, const int16_t f_corr, const int8_t pwr, const uint16_t baud) {}
+bool Rfm69::isIdle() { return true; }
+void Rfm69::startReceive(const int size) {}
+bool Rfm69::startReceiveContinuous() { return true; }
+int8_t Rfm69::getRssi() { return -60; }
+Rfm69::FifoLevel Rfm69::getFifoLevel() { return FIFO_EMPTY; }
+void Rfm69::writeFifo(const uint8_t *buf, uint8_t len) {}
+
+bool Rfm69::payloadReady() {
+    return fakeRfmRxPending();
+}
+
+uint8_t Rfm69::getPayload(uint8_t *buf) {
+    const uint8_t len = rxLen - rxPos;
+    memcpy(buf, &rxData[rxPos], len);
+    rxPos = rxLen;
+    return len;
+}
+
+uint8_t Rfm69::getPayload(uint8_t *buf, const uint8_t maxlen) {
+    uint8_t len = 0;
+    while ( (len < maxlen) && (rxPos < rxLen) )
+        buf[len++] = rxData[rxPos++];
+    return len;
+}
+
+bool RfmBase::getEdge(uint32_t &time, bool &level) {
+    if (edgePos == edgeLen)
+        return false;
+    time = edgeData[edgePos] & ~1UL;
+    level = (edgeData[edgePos++] & 1) != 0;
+    return true;
+}
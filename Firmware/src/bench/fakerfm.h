@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Rfm69 stand-in for host builds, received data is served from memory
+ * In continuous RX (startReceive(0)) getPayload() returns the loaded chips in chunks, otherwise
+ * the loaded payload is returned as one packet. Loaded edges are served by getEdge() in continuous
+ * mode. Transmitted bytes are dropped.
+ */
+void fakeRfmLoad(const uint8_t *data, const size_t len);
+void fakeRfmLoadEdges(const uint32_t *edges, const size_t len);
+bool fakeRfmRxPending();
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief pulse trains as captured at 433.92 MHz, in units of 50 µs samples
+ * Each train starts with the first high pulse and ends with the footer, pulses alternate high / low.
+ */
+static const uint8_t PULSES_ITTRISTATE[] = { // ittristate/A/1/2 on
+    6, 20, 8, 21, 8, 20, 8, 21, 6, 21, 8, 21, 7, 20, 7, 20, 7, 22, 22, 6, 8, 22, 6, 22, 7, 21, 7, 20,
+    7, 22, 6, 21, 6, 22, 6, 22, 6, 20, 21, 7, 7, 21, 22, 6, 8, 22, 20, 7, 5, 150
+};
+
+static const uint8_t PULSES_INTERTECHNO[] = { // intertechno/12345/3 on
+    2, 59, 6, 7, 5, 28, 6, 6, 5, 29, 5, 7, 7, 27, 5, 7, 6, 28, 5, 6, 7, 29, 5, 7, 6, 28, 7, 5, 6, 28,
+    7, 5, 6, 27, 5, 7, 7, 28, 6, 6, 6, 29, 5, 5, 7, 28, 6, 6, 5, 29, 5, 29, 7, 6, 6, 27, 7, 7, 6, 5,
+    5, 28, 6, 7, 7, 28, 7, 5, 5, 28, 6, 7, 6, 28, 5, 5, 5, 29, 7, 5, 7, 27, 6, 28, 6, 5, 7, 29, 7, 6,
+    5, 27, 7, 5, 5, 5, 7, 27, 6, 5, 7, 27, 7, 27, 7, 5, 6, 7, 5, 28, 5, 29, 7, 7, 5, 6, 7, 27, 6, 5,
+    7, 28, 5, 29, 6, 6, 5, 6, 7, 28, 5, 150
+};
+
+static const uint8_t PULSES_EV1527[] = { // EV1527/4711/5
+    16, 5, 15, 6, 16, 4, 4, 15, 5, 15, 14, 5, 15, 4, 5, 16, 6, 14, 14, 4, 4, 14, 6, 15, 16, 5, 4, 14,
+    4, 14, 6, 16, 6, 16, 5, 16, 4, 16, 5, 15, 15, 5, 4, 14, 16, 5, 6, 16, 5, 150
+};
+
+static const uint8_t PULSES_EMYLO[] = { // emylo/815 B, also decoded by EV1527
+    16, 4, 16, 4, 14, 6, 16, 5, 5, 14, 15, 5, 4, 15, 5, 16, 14, 4, 16, 5, 4, 14, 4, 16, 4, 15, 6, 14,
+    6, 15, 4, 16, 6, 16, 4, 14, 6, 16, 5, 15, 6, 14, 4, 14, 16, 5, 5, 14, 5, 150
+};
+
+static const uint8_t PULSES_NOISE[] = { // no frame, ends with a seperation gap
+    3, 11, 2, 27, 9, 1, 4, 17, 6, 2, 13, 8, 1, 22, 5, 3, 9, 14, 2, 6, 30, 1, 7, 12, 4, 2, 19, 5, 8, 3,
+    1, 16, 10, 4, 2, 25, 6, 9, 3, 150
+};
+
+/**
+ * @brief 868 MHz payloads as read from the FIFO after sync word match
+ */
+static const uint8_t PAYLOAD_LACROSSE[] = { // ID 2c, 21.5 °C, 55 %
+    0x92, 0xC6, 0x15, 0x37, 0x07
+};
+
+static const uint8_t PAYLOAD_EMT7170[] = { // ID 12345678
+    0x12, 0x34, 0x56, 0x78, 0x81, 0x2C, 0x03, 0xE8, 0xB4, 0x00, 0x64, 0x3C
+};
+
+static const uint8_t PAYLOAD_BRESSER[] = { // ID 3a81, 21.5 °C, 63 %
+    0x1A, 0xA8, 0x90, 0x2B, 0x8D, 0xAA, 0xAA, 0xAB, 0x8A, 0x2A, 0xAA, 0xB8, 0x9A, 0xAA, 0x8B, 0xFA,
+    0xC9, 0xAB, 0x89, 0xEF, 0xA9, 0xAA, 0xAA, 0xAA, 0xAA
+};
+
+static const uint8_t PAYLOAD_EC3K[] = { // ID 1234, scrambled HDLC frame
+    0xD2, 0xB1, 0x6F, 0x18, 0xEC, 0xA8, 0x16, 0x7F, 0xC6, 0x69, 0x2F, 0x0C, 0xCD, 0xE0, 0x12, 0x5B,
+    0x86, 0xAB, 0x03, 0x48, 0xE0, 0x5E, 0x51, 0x0E, 0x6B, 0x2D, 0x8E, 0xC0, 0x15, 0x2A, 0xBC, 0x52,
+    0xB8, 0xAA, 0xCD, 0x3A, 0x52, 0xE7, 0x82, 0x52, 0xB5, 0x58, 0xD0, 0xF4, 0x32, 0x6C, 0x6A, 0xA5,
+    0xCA, 0x5B, 0x15, 0xC9, 0x83, 0x29, 0xA6, 0x5B, 0xE3, 0xC6, 0x98, 0xDF
+};
+
+/**
+ * @brief payload of PAYLOAD_EC3K after descrambling and HDLC unstuffing, ending with its CRC
+ */
+static const uint8_t PAYLOAD_EC3K_HDLC[] = {
+    0x01, 0x23, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x7B, 0x00, 0x20, 0x00, 0x8C, 0x93, 0x9A, 0xA1, 0xA8, 0xAF, 0xB6, 0xBD, 0xC4, 0xCB, 0xD2, 0xD9,
+    0xE0, 0xE7, 0xEE, 0xF5, 0xFC, 0x03, 0x0A, 0x0C, 0x42
+};
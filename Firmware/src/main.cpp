@@ -7,6 +7,7 @@
 #include "main.h"
 #include "applications/868gw.h"
 #include "applications/fs20.h"
+#include "applications/lora.h"
 #include "applications/rc433.h"
 #include "html.h"
 
@@ -36,6 +37,11 @@ static const IPAddress apAddress(4, 3, 2, 1);
 static const IPAddress apSubnet(255, 255, 255, 0);
 static const uint16_t WEBPORT = 80;
 static const uint8_t DNS_PORT = 53;
+static const uint8_t PIN_RFM_SS = 16;
+static const uint8_t PIN_RFM_DIO0 = 9; // via R to GPIO9, needs DIO flash mode
+static const uint8_t PIN_RFM_DIO2 = 10; // via R to GPIO10, needs DIO flash mode
+static const uint8_t PIN_RFM2_SS = 4; // default chipselect of a second module, its DIOs are optional
+static const uint8_t RADIOSLOTS = 2;
 
 AsyncWebServer websrv(WEBPORT);
 AsyncWebSocket ws("/ws");
@@ -50,38 +56,112 @@ String mqttUser;
 String mqttPass;
 String baseTopic;
 
-Rfm69 *rfm69 = nullptr;
+/**
+ * @brief radio module with the application running on it
+ * The first module is set up by the top level of radio.json and config.json, a second one on
+ * its own chipselect by their "radio2" objects with the same keys.
+ */
+struct RadioSlot {
+    RfmBase *radio;
+    RadioApplication *app;
+    int appType; // "application" of config.json, -1: none
+};
+
+static RadioSlot slots[RADIOSLOTS] = {
+    {nullptr, nullptr, -1},
+    {nullptr, nullptr, -1}
+};
+
+/**
+ * @brief creates and initializes the driver for a module type
+ * 
+ * @return nullptr for unknown types
+ */
+RfmBase *createRadio(const uint8_t rfmType, const uint8_t pinSS, const uint8_t pinDio0, const uint8_t pinDio2) {
+    switch (rfmType) {
+    case RFM_TYPE_RFM69xx:
+    case RFM_TYPE_RFM69Hxx: {
+        Rfm69 *rfm = new Rfm69;
+        rfm->begin(pinSS, rfmType == RFM_TYPE_RFM69Hxx, pinDio0, pinDio2);
+        return rfm;
+    }
+
+    case RFM_TYPE_RFM95:
+    case RFM_TYPE_RFM96:
+    case RFM_TYPE_RFM97:
+    case RFM_TYPE_RFM98: {
+        Rfm9x *rfm = new Rfm9x;
+        rfm->begin(pinSS, pinDio0, pinDio2);
+        return rfm;
+    }
+
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * @brief deletes application and driver of a slot, the application uses the driver
+ */
+void clearSlot(RadioSlot &slot) {
+    if (slot.app != nullptr) {
+        delete slot.app;
+        slot.app = nullptr;
+    }
+    slot.appType = -1;
+    if (slot.radio != nullptr) {
+        delete slot.radio;
+        slot.radio = nullptr;
+    }
+}
 
 void loadRadioSetup() {
     File f = LittleFS.open(FPSTR(FILE_RADIO), "r");
     if (f) {
         JsonDocument cfg;
         if (deserializeJson(cfg, f) == DeserializationError::Ok) {
-            if (rfm69 != nullptr)
-                delete rfm69;
-
-            switch (cfg[F("rfmType")].as<int>()) {
-            case RFM_TYPE_RFM69xx:
-                rfm69 = new Rfm69;
-                rfm69->begin(16, false);
-                break;
-
-            case RFM_TYPE_RFM69Hxx:
-                rfm69 = new Rfm69;
-                rfm69->begin(16, true);
-                break;
-
-            default:
-                break;
+            for (auto &slot : slots)
+                clearSlot(slot);
+
+            slots[0].radio = createRadio(cfg[F("rfmType")].as<uint8_t>(), PIN_RFM_SS, PIN_RFM_DIO0, PIN_RFM_DIO2);
+            if (slots[0].radio != nullptr)
+                slots[0].radio->setFCorr(cfg[F("fCorr")]);
+
+            JsonObject second = cfg[F("radio2")].as<JsonObject>();
+            const uint8_t pinSS = second[F("pinSS")] | PIN_RFM2_SS;
+            if ( !second.isNull() && (pinSS != PIN_RFM_SS) ) {
+                slots[1].radio = createRadio(second[F("rfmType")].as<uint8_t>(), pinSS,
+                    second[F("pinDio0")] | (uint8_t) RfmBase::NOPIN, second[F("pinDio2")] | (uint8_t) RfmBase::NOPIN);
+                if (slots[1].radio != nullptr)
+                    slots[1].radio->setFCorr(second[F("fCorr")]);
             }
-
-            if (rfm69 != nullptr)
-                rfm69->setFCorr(cfg[F("fCorr")]);
         }
         f.close();
     }
 }
 
+/**
+ * @brief only one RC pulse application can run, they share the codecs' static state
+ */
+bool isRcApplication(const int appType) {
+    return (appType == 0) || (appType == 2);
+}
+
+RadioApplication *createApplication(RfmBase *radio, const int appType, const JsonObject &settings) {
+    switch (appType) {
+    case 0:
+        return new Rc433Transceiver(radio, settings);
+    case 1:
+        return new Gw868(radio, settings);
+    case 2:
+        return new FS20(radio, settings);
+    case 3:
+        return new LoraReceiver(radio, settings);
+    default:
+        return nullptr;
+    }
+}
+
 void setConfig(const JsonObject &obj) {
     if (obj.containsKey(F("mqtt"))) {
         const JsonObject &jMqtt = obj[F("mqtt")];
@@ -107,34 +187,49 @@ void setConfig(const JsonObject &obj) {
         mqtt.setBufferSize(1024);
     }
 
-    if (obj.containsKey(F("application"))) { 
-        if (radioapp != nullptr) {
-            delete radioapp;
-            radioapp = nullptr;
-        }
+    JsonObject slotCfg[RADIOSLOTS] = {obj, obj[F("radio2")].as<JsonObject>()};
 
-        switch (obj[F("application")].as<int>()) {
-        case 0:
-            if (rfm69 != nullptr)
-                radioapp = new Rc433Transceiver(obj[F("appSettings")].as<JsonObject>());
-            break;
-        case 1:
-            if (rfm69 != nullptr)
-                radioapp = new Gw868(obj[F("appSettings")].as<JsonObject>());
-            break;
-        case 2:
-            if (rfm69 != nullptr)
-                radioapp = new FS20(obj[F("appSettings")].as<JsonObject>());
-            break;
+    // all applications to replace are stopped first, the RC pulse application may move
+    for (uint8_t i=0; i<RADIOSLOTS; i++) {
+        if ( !slotCfg[i].containsKey(F("application")) || (slots[i].app == nullptr) )
+            continue;
+        delete slots[i].app;
+        slots[i].app = nullptr;
+        slots[i].appType = -1;
+    }
 
-        default:
-            break;
+    for (uint8_t i=0; i<RADIOSLOTS; i++) {
+        RadioSlot &slot = slots[i];
+        if ( slotCfg[i].isNull() || (slot.radio == nullptr) )
+            continue;
+
+        if (slotCfg[i].containsKey(F("application"))) {
+            const int appType = slotCfg[i][F("application")].as<int>();
+            bool rcRunning = false;
+            for (auto &other : slots)
+                rcRunning |= isRcApplication(other.appType);
+
+            if (isRcApplication(appType) && rcRunning)
+                ws.textAll(F("RC pulse application runs on the other radio already"));
+            else {
+                slot.app = createApplication(slot.radio, appType, slotCfg[i][F("appSettings")].as<JsonObject>());
+                if (slot.app != nullptr)
+                    slot.appType = appType;
+            }
         }
+
+        int8_t pwr = slotCfg[i][F("txPwr")] | 13;
+        slot.radio->setTxPower(pwr);
     }
+}
 
-    if (rfm69 != nullptr) {
-        int8_t pwr = obj[F("txPwr")] | 13;
-        rfm69->setTxPower(pwr);
+void loadConfig() {
+    File f = LittleFS.open(FPSTR(FILE_CONFIG), "r");
+    if (f) {
+        JsonDocument cfg;
+        if (deserializeJson(cfg, f) == DeserializationError::Ok)
+            setConfig(cfg.as<JsonObject>());
+        f.close();
     }
 }
 
@@ -168,14 +263,20 @@ void wiFiEvent(WiFiEvent_t event) {
 }
 
 void mqttCallback(const char topic[], byte* payload, unsigned int length) {
-    if (radioapp != nullptr) {
-        String sTop(topic);
-        sTop = sTop.substring(baseTopic.length() + 1);
-        String sPayload;
-        sPayload.concat((const char*) payload, length);
-        radioapp->onMqttMessage(sTop, sPayload);
-        ws.textAll("Rec. MQTT ~/" + sTop + ": " + sPayload);
+    String sTop(topic);
+    sTop = sTop.substring(baseTopic.length() + 1);
+    String sPayload;
+    sPayload.concat((const char*) payload, length);
+
+    bool handled = false;
+    for (auto &slot : slots) {
+        if (slot.app != nullptr) {
+            slot.app->onMqttMessage(sTop, sPayload);
+            handled = true;
+        }
     }
+    if (handled)
+        ws.textAll("Rec. MQTT ~/" + sTop + ": " + sPayload);
 }
 
 void setup() {
@@ -262,6 +363,26 @@ void setup() {
         JsonObject jMqtt = doc[F("mqtt")].to<JsonObject>();
         jMqtt[F("state")] = mqtt.state();
 
+        for (uint8_t i=0; i<RADIOSLOTS; i++) {
+            RfmBase *radio = slots[i].radio;
+            const String suffix = (i > 0) ? String(i + 1) : String(); // radio, radio2
+            if (radio != nullptr) {
+                JsonObject jRadio = doc[String(F("radio")) + suffix].to<JsonObject>();
+                jRadio[F("spiTransactions")] = radio->getSpiTransactions();
+                jRadio[F("spiBytes")] = radio->getSpiBytes();
+                jRadio[F("spiBytesSaved")] = radio->getSpiBytesSaved();
+                jRadio[F("regCacheMismatches")] = radio->getRegCacheMismatches();
+                jRadio[F("modeTimeouts")] = radio->getModeTimeouts();
+                jRadio[F("edgeOverruns")] = radio->getEdgeOverruns();
+                jRadio[F("fifoOverruns")] = radio->getFifoOverruns();
+            }
+
+            if (slots[i].app != nullptr) {
+                JsonObject jApp = doc[String(F("application")) + suffix].to<JsonObject>();
+                slots[i].app->getStatus(jApp);
+            }
+        }
+
         AsyncResponseStream *response = request->beginResponseStream(FPSTR(APP_JSON));
         serializeJson(doc, *response);
         request->send(response); });
@@ -310,6 +431,8 @@ void setup() {
                 serializeJson(doc[F("radio")], f);
                 f.close();
                 loadRadioSetup();
+                if (!doc.containsKey(F("config")))
+                    loadConfig(); // applications were stopped with their radios
             }
 
             if (doc.containsKey(F("config"))) {
@@ -333,27 +456,12 @@ void setup() {
         JsonDocument doc;
         deserializeJson(doc, (char*) data, len);
         
-        if (rfm69 != nullptr) {
-            delete rfm69;
-            rfm69 = nullptr;
-        }
+        clearSlot(slots[0]);
+        RfmBase *radio = createRadio(doc[F("rfmType")].as<uint8_t>(), PIN_RFM_SS, PIN_RFM_DIO0, PIN_RFM_DIO2);
+        slots[0].radio = radio;
 
-        uint8_t rfmtype = doc[F("rfmType")].as<uint8_t>();
-        switch (rfmtype) {
-        case RFM_TYPE_RFM69xx:
-            rfm69 = new Rfm69();
-            rfm69->begin(16, false);
-            break;
-        case RFM_TYPE_RFM69Hxx:
-            rfm69 = new Rfm69();
-            rfm69->begin(16, true);
-            break;
-        default: 
-            break;
-        }
-
-        if (rfm69 != nullptr) {
-            rfm69->txTest(
+        if (radio != nullptr) {
+            radio->txTest(
                 doc[F("freq")].as<uint32_t>(),
                 doc[F("fCorr")].as<int16_t>(), 
                 doc[F("pwr")].as<int8_t>(),
@@ -392,13 +500,7 @@ void setup() {
         request->redirect(F("/"));
     });
 
-    File f = LittleFS.open(FPSTR(FILE_CONFIG), "r");
-    if (f) {
-        JsonDocument cfg;
-        if (deserializeJson(cfg, f) == DeserializationError::Ok)
-            setConfig(cfg.as<JsonObject>());
-        f.close();
-    }
+    loadConfig();
 
     mqtt.setCallback(mqttCallback);
 }
@@ -463,10 +565,13 @@ void loop() {
         }
     }
 
-    if (rfm69 != nullptr) {
-        rfm69->loop();
-        if (radioapp != nullptr)
-            radioapp->loop();
+    // each module's driver and application get one turn per loop()
+    for (auto &slot : slots) {
+        if (slot.radio != nullptr) {
+            slot.radio->loop();
+            if (slot.app != nullptr)
+                slot.app->loop();
+        }
     }
 
     if (rebootFlag) {
@@ -1,6 +1,7 @@
 #include <radioapplication.h>
 
-RadioApplication::RadioApplication() {
+RadioApplication::RadioApplication(RfmBase *radio):
+        radio(radio) {
     websrv.addHandler(this);
 }
 
@@ -3,12 +3,18 @@
 #include <ArduinoJson.h>
 #include "main.h"
 
+/**
+ * @brief application bound to one radio module, several applications run side by side on
+ * modules of their own
+ */
 class RadioApplication: public AsyncWebHandler {
+protected:
+    RfmBase *radio;
 public:
-    RadioApplication();
+    RadioApplication(RfmBase *radio);
     virtual ~RadioApplication();
     virtual void loop() = 0;
     virtual void onMqttMessage(String topic, String payload) {}
+    virtual void getStatus(JsonObject &obj) {}
 };
 
-extern RadioApplication *radioapp;
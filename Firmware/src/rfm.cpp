@@ -3,6 +3,10 @@
 #define FXOSC 32E6
 #define FSTEP (FXOSC / (1UL<<19))
 
+static const uint32_t MODETIMEOUT = 20; // ms until ModeReady, some 100 µs are typical
+
+volatile bool RfmBase::spiBusy = false;
+
 /**
  * @brief set hardware-environment for RFM module
  * 
@@ -10,44 +14,173 @@
   */
 void RfmBase::begin(const uint8_t pinSS) {
     this->pinSS = pinSS;
+    spiTransactions = 0;
+    spiBytes = 0;
+    spiBytesSaved = 0;
+    regCacheMismatches = 0;
+    modeTimeouts = 0;
+    f_corr = 0;
+    fei = 0;
+    edgeCapture = false;
+    edgeHead = 0;
+    edgeTail = 0;
+    edgeOverruns = 0;
+    fifoOverruns = 0;
+    crcErrors = 0;
+    setUncachedRegs(nullptr, 0);
+#ifdef DEBUGREGCACHE
+    regCacheVerify = true;
+#else
+    regCacheVerify = false;
+#endif
+    resyncRegCache();
     digitalWrite(pinSS, HIGH);
     pinMode(pinSS, OUTPUT);
 }
 
-uint8_t RfmBase::readReg(const uint8_t reg) {
+RfmBase::~RfmBase() {
+    stopEdgeCapture();
+}
+
+/**
+ * @brief drive chipselect low directly via GPIO registers, digitalWrite takes about 1 µS
+ * Statistics are updated while spiBusy is set only, so readRegIsr() can't interrupt an update.
+ */
+inline void IRAM_ATTR RfmBase::select() {
+    spiBusy = true;
+#ifdef ARDUINO_ARCH_ESP8266
+    if (pinSS == 16)
+        GP16O &= ~1;
+    else
+        GPOC = 1 << pinSS;
+#else
     digitalWrite(pinSS, LOW);
-    uint8_t result;
-    SPI.transfer(reg);
-    result = SPI.transfer(0);
+#endif
+    spiTransactions++;
+}
+
+inline void IRAM_ATTR RfmBase::deselect() {
+#ifdef ARDUINO_ARCH_ESP8266
+    if (pinSS == 16)
+        GP16O |= 1;
+    else
+        GPOS = 1 << pinSS;
+#else
     digitalWrite(pinSS, HIGH);
+#endif
+    spiBusy = false;
+}
+
+/**
+ * @brief drops all cached register values, they are read from the chip again on next use
+ */
+void RfmBase::resyncRegCache() {
+    memset(regCached, 0, sizeof(regCached));
+}
+
+/**
+ * @brief registers written only to trigger something, like a mode change or clearing the FIFO
+ * They must not be rewritten by restoreRegs(), so they are kept out of the cache.
+ *
+ * @param regs command and status registers
+ * @param cmdReg register holding both configuration and command bits
+ * @param cmdBits command bits of cmdReg, cached as 0
+ */
+void RfmBase::setUncachedRegs(const uint8_t regs[], const uint8_t num, const uint8_t cmdReg, const uint8_t cmdBits) {
+    memset(regUncached, 0, sizeof(regUncached));
+    for (uint8_t i=0; i<num; i++) {
+        regUncached[regs[i] >> 5] |= 1UL << (regs[i] & 31);
+        regCached[regs[i] >> 5] &= ~(1UL << (regs[i] & 31));
+    }
+    commandReg = cmdReg;
+    commandBits = cmdBits;
+}
+
+void RfmBase::cacheReg(const uint8_t reg, const uint8_t value) {
+    if ( (reg == 0) || (reg >= sizeof(regCache)) || isUncached(reg) ) // FIFO, commands and status are not cached
+        return;
+    regCache[reg] = (reg == commandReg) ? (value & ~commandBits) : value;
+    regCached[reg >> 5] |= 1UL << (reg & 31);
+}
+
+/**
+ * @brief reads a register from the shadow copy, from the chip on first access
+ * Only for configuration registers which are not modified by the chip itself.
+ */
+uint8_t RfmBase::readRegCached(const uint8_t reg) {
+    if (isCached(reg) && !regCacheVerify) {
+        spiBytesSaved += 2;
+        return regCache[reg];
+    }
+
+    const uint8_t value = readReg(reg);
+    if (isCached(reg) && (value != regCache[reg]))
+        regCacheMismatches++;
+    cacheReg(reg, value);
+    return value;
+}
+
+uint8_t RfmBase::readReg(const uint8_t reg) {
+    select();
+    const uint8_t result = SPI.transfer16(reg << 8); // address and data in one 16 bit transfer
+    spiBytes += 2;
+    deselect();
     return result;
 }
 
+/**
+ * @brief register read from interrupt context
+ * The SPI library is not in IRAM, so on ESP8266 the HSPI registers are used directly.
+ * 
+ * @return false if the main loop is using the bus
+ */
+bool IRAM_ATTR RfmBase::readRegIsr(const uint8_t reg, uint8_t &value) {
+    if (spiBusy)
+        return false;
+
+#ifdef ARDUINO_ARCH_ESP8266
+    while (SPI1CMD & SPIBUSY) {}
+    SPI1U1 = (SPI1U1 & ~((SPIMMOSI << SPILMOSI) | (SPIMMISO << SPILMISO))) | (15 << SPILMOSI) | (15 << SPILMISO);
+    SPI1W0 = reg;
+    select();
+    SPI1CMD |= SPIBUSY;
+    while (SPI1CMD & SPIBUSY) {}
+    value = SPI1W0 >> 8;
+    spiBytes += 2;
+    deselect();
+#else
+    value = readReg(reg);
+#endif
+    return true;
+}
+
 uint16_t RfmBase::readReg16(const uint8_t reg) {
-    digitalWrite(pinSS, LOW);
-    uint16_t result;
+    uint8_t buf[2];
+    readRegBuf(reg, buf, sizeof(buf));
+    return buf[0] << 8 | buf[1];
+}
+
+/**
+ * @brief burst read of consecutive registers, FIFO is read repeatedly
+ */
+void RfmBase::readRegBuf(const uint8_t reg, uint8_t *buf, const size_t size) {
+    select();
     SPI.transfer(reg);
-    result = SPI.transfer(0x00);
-    result <<= 8;
-    result |= SPI.transfer(0x00);
-    digitalWrite(pinSS, HIGH);
-    return result;
+    SPI.transferBytes(nullptr, buf, size);
+    spiBytes += size + 1;
+    deselect();
 }
 
 void RfmBase::readFifo(uint8_t *buf, const size_t size) {
-    digitalWrite(pinSS, LOW);
-    SPI.transfer(0x00); // FIFO reg
-    for (size_t i=0; i<size; i++)
-        *buf++ = SPI.transfer(0x00);
-
-    digitalWrite(pinSS, HIGH);
+    readRegBuf(0x00, buf, size); // FIFO reg
 }
 
 void RfmBase::writeReg(const uint8_t reg, const uint8_t value) {
-    digitalWrite(pinSS, LOW);
-    SPI.transfer(0x80 | reg);
-    SPI.transfer(value);
-    digitalWrite(pinSS, HIGH);
+    select();
+    SPI.write16((0x80 | reg) << 8 | value);
+    spiBytes += 2;
+    deselect();
+    cacheReg(reg, value);
 }
 
 void RfmBase::writeReg16(const uint8_t reg, const uint16_t value) {
@@ -57,39 +190,177 @@ void RfmBase::writeReg16(const uint8_t reg, const uint16_t value) {
     writeRegBuf(reg, buf, sizeof(buf));
 }
 
+/**
+ * @brief burst write of consecutive registers, FIFO is written repeatedly
+ */
 void RfmBase::writeRegBuf(const uint8_t reg, const uint8_t *buf, const size_t size) {
-    digitalWrite(pinSS, LOW);
-
-    SPI.transfer(0x80 | reg);
-    uint8_t *p = (uint8_t *) buf;
-    for (size_t i=0; i<size; i++)
-        SPI.transfer(*p++);
-
-    digitalWrite(pinSS, HIGH);
+    select();
+    SPI.write(0x80 | reg);
+    SPI.writeBytes(buf, size);
+    spiBytes += size + 1;
+    deselect();
+    if (reg != 0) {
+        for (size_t i=0; i<size; i++)
+            cacheReg(reg + i, buf[i]);
+    }
 }
 
+/**
+ * @brief read-modify-write of a register, based on the shadow copy
+ * The write is skipped if the register already holds the new value.
+ */
 void RfmBase::setReg(const uint8_t reg, const uint8_t set, const uint8_t clear) {
-    uint8_t val = readReg(reg);
-    val &= ~clear;
-    val |= set;
+    const bool cached = isCached(reg);
+    const uint8_t old = readRegCached(reg);
+    const uint8_t val = (old & ~clear) | set;
+    if (cached && !regCacheVerify && (val == old)) {
+        spiBytesSaved += 2;
+        return;
+    }
     writeReg(reg, val);
 }
 
+/**
+ * @brief writes all cached registers back to the chip, e.g. after the module lost its configuration
+ */
+void RfmBase::restoreRegs() {
+    uint8_t reg = 1;
+    while (reg < sizeof(regCache)) {
+        uint8_t len = 0;
+        while ( (reg + len < sizeof(regCache)) && isCached(reg + len) )
+            len++;
+
+        if (len > 0)
+            writeRegBuf(reg, &regCache[reg], len);
+        reg += len + 1;
+    }
+}
+
+/**
+ * @brief writes a list of registers
+ * Runs of consecutive register addresses are written in a single burst.
+ */
+void RfmBase::writeConfig(const RfmConfig cfg[], const uint8_t num) {
+    uint8_t buf[16];
+    uint8_t i = 0;
+    while (i < num) {
+        const uint8_t reg = cfg[i].reg;
+        uint8_t len = 0;
+        do {
+            buf[len++] = cfg[i++].val;
+        } while ( (i < num) && (len < sizeof(buf)) && (reg != 0) && (cfg[i].reg == reg + len) );
+
+        if (len == 1)
+            writeReg(reg, buf[0]);
+        else
+            writeRegBuf(reg, buf, len);
+    }
+}
+
+/**
+ * @brief RxBwMant / RxBwExp of the narrowest channel filter passing bw_hz, same on RFM69 and SX127x
+ * 
+ * @param ook OOK filters are half as wide as FSK filters with the same setting
+ */
+uint8_t RfmBase::rxBwValue(const uint32_t bw_hz, const bool ook) {
+    static const uint8_t MANT[] = {24, 20, 16};
+    for (int8_t e=7; e>=0; e--) {
+        for (uint8_t m=0; m<sizeof(MANT); m++) {
+            const uint32_t bw = FXOSC / ((uint32_t) MANT[m] << (e + (ook ? 3 : 2)));
+            if (bw >= bw_hz)
+                return (2 - m) << 3 | e;
+        }
+    }
+    return 0; // widest filter
+}
+
+/**
+ * @brief edge of the demodulated data on DIO2 in continuous mode, appended to edgeRing
+ */
+void IRAM_ATTR RfmBase::dio2Isr(void *arg) {
+    RfmBase *rfm = static_cast<RfmBase*>(arg);
+    const uint8_t head = rfm->edgeHead;
+    const uint8_t next = (head + 1) & (EDGERINGSIZE - 1);
+    if (next == rfm->edgeTail) {
+        rfm->edgeOverruns++;
+        return;
+    }
+    rfm->edgeRing[head] = (micros() & ~1UL) | digitalRead(rfm->pinDio2);
+    rfm->edgeHead = next;
+}
+
+/**
+ * @brief oldest edge captured in continuous mode
+ * 
+ * @param time micros() of the edge, even values only
+ * @param level level after the edge
+ * @return false if there is no edge
+ */
+bool RfmBase::getEdge(uint32_t &time, bool &level) {
+    const uint8_t tail = edgeTail;
+    if (tail == edgeHead)
+        return false;
+
+    const uint32_t e = edgeRing[tail];
+    time = e & ~1UL;
+    level = (e & 1) != 0;
+    edgeTail = (tail + 1) & (EDGERINGSIZE - 1);
+    return true;
+}
+
+/**
+ * @brief drops old edges and timestamps edges on DIO2 from now on
+ */
+void RfmBase::startEdgeCapture() {
+    edgeTail = edgeHead;
+    if (!edgeCapture) {
+        attachInterruptArg(digitalPinToInterrupt(pinDio2), dio2Isr, this, CHANGE);
+        edgeCapture = true;
+    }
+}
+
+/**
+ * @return false if edges were not captured
+ */
+bool RfmBase::stopEdgeCapture() {
+    if (!edgeCapture)
+        return false;
+
+    detachInterrupt(digitalPinToInterrupt(pinDio2));
+    edgeCapture = false;
+    return true;
+}
+
+Rfm69::~Rfm69() {
+    if (pinDio0 != NOPIN)
+        detachInterrupt(digitalPinToInterrupt(pinDio0));
+}
+
 /**
  * @brief set hardware-environment for RFM69 module
  * 
  * @param pinSS GPIO for chipselect
  * @param isHighPower true if H version is used (RFM69H(W), RFM69HC(W))
+ * @param pinDio0 GPIO connected to DIO0, NOPIN: poll the IRQ flags via SPI
+ * @param pinDio2 GPIO connected to DIO2, NOPIN: no continuous mode reception
  */
-void Rfm69::begin(const uint8_t pinSS, const bool isHighPower) {
+void Rfm69::begin(const uint8_t pinSS, const bool isHighPower, const uint8_t pinDio0, const uint8_t pinDio2) {
     RfmBase::begin(pinSS);
     highPower = isHighPower;
-    
+    this->pinDio0 = pinDio0;
+    this->pinDio2 = pinDio2;
+    modulation = MODULATION_FSK;
+    dio0Event = EVENT_PACKETSENT;
+    events = 0;
+
+    static const uint8_t UNCACHED[] = {RegOpMode, RegIrqFlags1, RegIrqFlags2};
+    setUncachedRegs(UNCACHED, sizeof(UNCACHED), RegAfcFei, 1<<5 | 1<<1 | 1<<0); // FeiStart, AfcClear, AfcStart
+
     setMode(MODE_SLEEP);
 
     const uint16_t deviation = 9900 / (32E06 / (1UL<<19));
 
-    const Rfm69Config cfg[] = {
+    const RfmConfig cfg[] = {
         {RegOpMode, MODE_STDBY<<2}, // standby
         {RegFdevMsb,        deviation >> 8},
         {RegFdevLsb,        deviation & 0xFF},
@@ -115,14 +386,73 @@ void Rfm69::begin(const uint8_t pinSS, const bool isHighPower) {
 
     writeConfig(cfg, sizeof(cfg)/sizeof(cfg[0]));
     setMode(MODE_FS);
+
+    if (pinDio0 != NOPIN) {
+        pinMode(pinDio0, INPUT);
+        attachInterruptArg(digitalPinToInterrupt(pinDio0), dio0Isr, this, RISING);
+    }
+    if (pinDio2 != NOPIN)
+        pinMode(pinDio2, INPUT);
+}
+
+/**
+ * @brief rising edge on DIO0, timestamps the event and samples RSSI at sync address match
+ */
+void IRAM_ATTR Rfm69::dio0Isr(void *arg) {
+    Rfm69 *rfm = static_cast<Rfm69*>(arg);
+    uint8_t event = rfm->dio0Event;
+
+    if (event == EVENT_SYNC) {
+        rfm->syncTime = micros();
+        uint8_t value;
+        if (rfm->readRegIsr(RegRssiValue, value)) {
+            rfm->syncRssi = value;
+            event |= EVENT_RSSI;
+        }
+    }
+    rfm->events |= event;
 }
 
-void Rfm69::writeConfig(const Rfm69Config cfg[], const uint8_t num) {
-    for (uint8_t i=0; i<num; i++)
-        writeReg(cfg[i].reg, cfg[i].val);
+/**
+ * @brief routes an event to DIO0, RegDioMapping1 is written only if the mapping changes
+ * 
+ * @param mapping Dio0Mapping of the current / next mode
+ */
+void Rfm69::mapDio0(const uint8_t mapping, const Events event) {
+    dio0Event = event;
+    setReg(RegDioMapping1, mapping << 6, 3 << 6);
+    if (digitalRead(pinDio0) == HIGH) { // signal was already set, no edge
+        noInterrupts();
+        events |= event;
+        interrupts();
+    }
+}
+
+/**
+ * @brief second half of sync address match handling, DIO0 is switched over to PayloadReady
+ */
+void Rfm69::handleSync() {
+    if ((events & EVENT_RSSI) != 0)
+        rssi = -syncRssi / 2;
+    else
+        rssi = -readReg(RegRssiValue) / 2; // bus was in use at sync address match
+    writeReg(RegAfcFei, 1<<5); //Fei start
+    rssiflag = true;
+    mapDio0(1, EVENT_PAYLOADREADY);
 }
 
 void Rfm69::loop() {
+    if (!modeReady)
+        isModeReady();
+
+    if ( (pinDio0 != NOPIN) && (mode > MODE_FS) ) {
+        if ( (mode == MODE_TX) && ((events & EVENT_PACKETSENT) != 0) )
+            setMode(MODE_FS);
+        else if ( (mode == MODE_RX) && !rssiflag && ((events & EVENT_SYNC) != 0) )
+            handleSync();
+        return;
+    }
+
     if (mode > MODE_FS) {
         uint8_t f2 = readReg(RegIrqFlags2);
         switch (mode) {
@@ -181,27 +511,98 @@ void Rfm69::setMode(const Mode mode) {
     }
     writeReg(RegOpMode, mode << 2);
     this->mode = mode;
+    modeReady = false;
+    modeStart = millis();
+}
 
-    while (true) {
-        auto if1 = readReg(RegIrqFlags1);
-        if ((if1 & 1<<7) != 0)
-            break;
+/**
+ * @brief checks if the last mode transition has completed
+ * setMode() does not wait, the sequencer accepts register and FIFO access and further mode
+ * requests during a transition. A module not getting ready within MODETIMEOUT is reconfigured.
+ */
+bool Rfm69::isModeReady() {
+    if (modeReady)
+        return true;
+
+    if ((readReg(RegIrqFlags1) & (1<<7)) != 0) {
+        modeReady = true;
+        return true;
     }
+
+    if (millis() - modeStart > MODETIMEOUT)
+        recoverMode();
+    return false;
+}
+
+/**
+ * @brief module did not get ready, restore the configuration from the register cache and request
+ * the mode again
+ * The reset pin of the RFM is not connected, a brownout or hung sequencer is handled by rewriting
+ * all registers.
+ */
+void Rfm69::recoverMode() {
+    modeTimeouts++;
+    writeReg(RegOpMode, MODE_STDBY << 2);
+    restoreRegs();
+    setMode(mode); // RegOpMode is not cached
 }
 
 void Rfm69::stop() {
     setMode(MODE_STDBY);
 }
 
+/**
+ * @brief syncsize 0: no sync word, the FIFO is filled from the start of reception
+ */
 void Rfm69::setSync(const uint8_t *sync, const int syncsize) {
-    uint8_t sc = readReg(RegSyncConfig) & ~(1<<7 | 7<<3);
+    uint8_t sc = readRegCached(RegSyncConfig) & ~(1<<7 | 1<<6 | 7<<3);
     if (syncsize > 0) {
         sc |= 1<<7 | (syncsize - 1) << 3;
         writeRegBuf(RegSyncValue1, sync, syncsize);
     }
+    else
+        sc |= 1<<6; // FifoFillCondition always
     writeReg(RegSyncConfig, sc);
 }
 
+/**
+ * @brief packet mode with fixed or unlimited length, no whitening, no crc. The applications
+ * check their frames themselves.
+ */
+void Rfm69::setModulation(const Modulation modulation) {
+    stopContinuous();
+    this->modulation = modulation;
+    writeReg(RegDataModul, modulation << 3);
+    if (modulation == MODULATION_OOK)
+        writeReg(RegOokPeak, 1<<6 | 3<<0); // peak threshold, increment every 8 chips
+    writeReg(RegPacketConfig1, 0x00);
+}
+
+/**
+ * @brief select the channel filter, call after setModulation()
+ */
+void Rfm69::setRxBandwidth(const uint32_t bw_hz) {
+    writeReg(RegRxBw, 2<<5 | rxBwValue(bw_hz, modulation == MODULATION_OOK));
+}
+
+/**
+ * @param thresh RSSI threshold to start reception in -0.5 dBm
+ */
+void Rfm69::setRssiThreshold(const uint8_t thresh) {
+    writeReg(RegRssiThresh, thresh);
+}
+
+void Rfm69::setPreamble(const uint16_t len) {
+    writeReg16(RegPreambleMsb, len);
+}
+
+/**
+ * @brief FifoLevel threshold, transmission starts with the first byte in the FIFO
+ */
+void Rfm69::setFifoThreshold(const uint8_t thresh) {
+    writeReg(RegFifoThresh, 1<<7 | thresh);
+}
+
 void Rfm69::setAesKey(const uint8_t aeskey[16]) {
     writeRegBuf(RegAesKey1, aeskey, 16);
 }
@@ -212,12 +613,8 @@ void Rfm69::enableAes(const bool enable) {
 
 void Rfm69::setFreq(const uint32_t freq_hz) {
     uint32_t fword = (freq_hz / FSTEP) + f_corr;
-    writeReg16(RegFrfMsb, fword >> 8);
-    writeReg(RegFrfLsb, fword);
-}
-
-void Rfm69::setFCorr(const int16_t fcorr) {
-    this->f_corr = fcorr;
+    const uint8_t buf[] = {(uint8_t) (fword >> 16), (uint8_t) (fword >> 8), (uint8_t) fword};
+    writeRegBuf(RegFrfMsb, buf, sizeof(buf));
 }
 
 void Rfm69::setBitrate(const uint16_t bit_s) {
@@ -252,12 +649,19 @@ bool Rfm69::isIdle() {
 }
 
 bool Rfm69::payloadReady() {
+    if (pinDio0 != NOPIN) {
+        if (!rssiflag && ((events & EVENT_SYNC) != 0))
+            handleSync();
+        return (events & EVENT_PAYLOADREADY) != 0;
+    }
+
     auto iq2 = readReg(RegIrqFlags2);
     return ((iq2 & 1<<2) != 0);
 }
 
 void Rfm69::send(const uint8_t *data, const int size, const bool varSize) {
     setMode(MODE_FS);
+    stopContinuous();
     while (readReg(RegIrqFlags2) != 0) {
         volatile uint8_t f = readReg(RegFifo);
     }
@@ -271,6 +675,10 @@ void Rfm69::send(const uint8_t *data, const int size, const bool varSize) {
     }
 
     writeRegBuf(RegFifo, data, size);
+    if (pinDio0 != NOPIN) {
+        events = 0; // no events in FS mode
+        mapDio0(0, EVENT_PACKETSENT);
+    }
     setMode(MODE_TX);
 }
 
@@ -298,6 +706,7 @@ void Rfm69::txTest(const uint32_t freq_hz, const int16_t f_corr, const int8_t pw
  */
 void Rfm69::startReceive(const int size) {
     setMode(MODE_FS);
+    stopContinuous();
     rxSize = size;
     rssiflag = false;
 
@@ -312,11 +721,27 @@ void Rfm69::startReceive(const int size) {
         writeReg(RegPayloadLength, size);
     }
 
+    if (pinDio0 != NOPIN) {
+        events = 0; // no events in FS mode
+        if (size != 0)
+            mapDio0(2, EVENT_SYNC);
+        else
+            mapDio0(1, EVENT_PAYLOADREADY); // unlimited length, the FIFO is read continuously
+    }
     setMode(MODE_RX);
 }
 
+/**
+ * @brief reads the received packet, the FEI started at sync address match is read into fei
+ */
 uint8_t Rfm69::getPayload(uint8_t *buf) {
-    uint16_t fei = readReg16(RegFeiMsb);
+    uint8_t afc[RegFeiLsb - RegAfcFei + 1]; // RegAfcFei - RegFeiLsb in one burst
+    readRegBuf(RegAfcFei, afc, sizeof(afc));
+    if ((afc[0] & (1<<6)) != 0) // FeiDone
+        fei = (int16_t) (afc[RegFeiMsb - RegAfcFei] << 8 | afc[RegFeiLsb - RegAfcFei]) * FSTEP;
+    else
+        fei = 0;
+
     uint8_t result;
 
     if (rxSize == -1) {
@@ -330,10 +755,25 @@ uint8_t Rfm69::getPayload(uint8_t *buf) {
     return result;
 }
 
+/**
+ * @brief reads what the FIFO holds up to maxlen, in continuous reception with unlimited length
+ * More than the FIFO threshold is read in one burst, the rest byte by byte.
+ */
 uint8_t Rfm69::getPayload(uint8_t *buf, const uint8_t maxlen) {
     uint8_t result = 0;
 
     auto iq2 = readReg(RegIrqFlags2);
+    if ((iq2 & (1<<4)) != 0) { // FifoOverrun
+        fifoOverruns++;
+        writeReg(RegIrqFlags2, 1<<4); // clears the flag and the FIFO, the samples in it are not contiguous
+        return 0;
+    }
+    const uint8_t burst = (readRegCached(RegFifoThresh) & 0x7F) + 1;
+    if ( ((iq2 & (1<<5)) != 0) && (burst <= maxlen) ) { // FifoLevel
+        readFifo(buf, burst);
+        result = burst;
+        iq2 = readReg(RegIrqFlags2);
+    }
     while ( (iq2 & (1<<6)) && (result < maxlen) )  { // FIFO not empty 
         buf[result++] = readReg(RegFifo);
         iq2 = readReg(RegIrqFlags2);
@@ -344,3 +784,543 @@ uint8_t Rfm69::getPayload(uint8_t *buf, const uint8_t maxlen) {
 int8_t Rfm69::getRssi() {
     return rssi;
 }
+
+/**
+ * @brief set RFM in continuous receive mode, edges of the demodulated data on DIO2 are
+ * timestamped by interrupt and read with getEdge()
+ * 
+ * @return false if DIO2 is not connected
+ */
+bool Rfm69::startReceiveContinuous() {
+    if (pinDio2 == NOPIN)
+        return false;
+
+    setMode(MODE_FS);
+    setReg(RegDataModul, 3<<5, 3<<5); // continuous mode without bit synchronizer
+    startEdgeCapture();
+    setMode(MODE_RX);
+    return true;
+}
+
+/**
+ * @brief back to packet mode
+ */
+void Rfm69::stopContinuous() {
+    if (stopEdgeCapture())
+        setReg(RegDataModul, 0<<5, 3<<5);
+}
+
+Rfm9x::~Rfm9x() {
+    if (pinDio0 != NOPIN)
+        detachInterrupt(digitalPinToInterrupt(pinDio0));
+}
+
+/**
+ * @brief set hardware-environment for RFM95 / RFM96 / RFM97 / RFM98 module
+ * The modules have PA_BOOST connected only.
+ * 
+ * @param pinSS GPIO for chipselect
+ * @param pinDio0 GPIO connected to DIO0, NOPIN: poll the IRQ flags via SPI
+ * @param pinDio2 GPIO connected to DIO2, NOPIN: no continuous mode reception
+ */
+void Rfm9x::begin(const uint8_t pinSS, const uint8_t pinDio0, const uint8_t pinDio2) {
+    RfmBase::begin(pinSS);
+    this->pinDio0 = pinDio0;
+    this->pinDio2 = pinDio2;
+    modulation = MODULATION_FSK;
+    opMode = 0; // FSK modem, HF band
+    rxSize = -1;
+    rssiflag = false;
+    rssi = 0;
+    snr = 0;
+    dio0Flag = false;
+    setUncachedFsk();
+
+    setMode(MODE_SLEEP);
+    writeFskConfig();
+    setFreq(868300000UL);
+    setMode(MODE_STDBY);
+
+    if (pinDio0 != NOPIN) {
+        pinMode(pinDio0, INPUT);
+        attachInterruptArg(digitalPinToInterrupt(pinDio0), dio0Isr, this, RISING);
+    }
+    if (pinDio2 != NOPIN)
+        pinMode(pinDio2, INPUT);
+}
+
+/**
+ * @brief rising edge on DIO0, mapping 00: PayloadReady in RX, PacketSent in TX, RxDone in LoRa mode
+ */
+void IRAM_ATTR Rfm9x::dio0Isr(void *arg) {
+    static_cast<Rfm9x*>(arg)->dio0Flag = true;
+}
+
+/**
+ * @brief defaults of the FSK / OOK modem, equivalent to Rfm69::begin()
+ */
+void Rfm9x::writeFskConfig() {
+    const uint16_t deviation = 9900 / FSTEP;
+
+    const RfmConfig cfg[] = {
+        {RegFdevMsb,        (uint8_t) (deviation >> 8)},
+        {RegFdevLsb,        (uint8_t) (deviation & 0xFF)},
+        {RegLna,            0x23}, // max gain, LNA boost in HF band
+        {RegRxConfig,       1<<3 | 1<<0}, // AgcAutoOn, RX triggered by RSSI threshold
+        {RegRssiConfig,     2}, // 8 samples
+        {RegRssiThresh,     220}, // *-0.5dBm
+        {RegRxBw,           rxBwValue(125000, false)},
+        {RegAfcBw,          rxBwValue(250000, false)},
+        {RegOokPeak,        1<<5 | 1<<3}, // bit synchronizer, peak threshold
+        {RegOokFix,         0x0C},
+        {RegOokAvg,         3<<5 | 0x12}, // peak threshold decrement every 8 chips
+        {RegPreambleDetect, 0xAA}, // on, 2 bytes, 10 chips tolerance
+        {RegPreambleMsb,    0},
+        {RegPreambleLsb,    10},
+        {RegSyncConfig,     0<<6 | 1<<4 | 3}, // no auto restart, sync on, 4 bytes
+        {RegPacketConfig1,  0<<7}, // fixed length, no data whitening, crc off
+        {RegPacketConfig2,  1<<6}, // packet mode
+        {RegPayloadLength,  0},
+        {RegFifoThresh,     0x8f},
+        {RegDioMapping1,    0<<6} // DIO0: PayloadReady / PacketSent
+    };
+
+    writeConfig(cfg, sizeof(cfg)/sizeof(cfg[0]));
+}
+
+void Rfm9x::setMode(const Mode mode) {
+    writeReg(RegOpMode, opMode | mode);
+    this->mode = mode;
+    modeReady = isLora(); // no ModeReady flag in LoRa mode
+    modeStart = millis();
+}
+
+/**
+ * @brief checks if the last mode transition has completed, see Rfm69::isModeReady()
+ */
+bool Rfm9x::isModeReady() {
+    if (modeReady)
+        return true;
+
+    if ((readReg(RegIrqFlags1) & (1<<7)) != 0) {
+        modeReady = true;
+        return true;
+    }
+
+    if (millis() - modeStart > MODETIMEOUT)
+        recoverMode();
+    return false;
+}
+
+/**
+ * @brief see Rfm69::recoverMode()
+ */
+void Rfm9x::recoverMode() {
+    modeTimeouts++;
+    writeReg(RegOpMode, opMode | MODE_STDBY);
+    restoreRegs();
+    setMode(mode); // RegOpMode is not cached
+}
+
+/**
+ * @brief switches between FSK / OOK and LoRa modem
+ * Registers 0x0D - 0x3F belong to the selected modem, so the register cache is dropped and the
+ * FSK / OOK defaults are written again when switching back.
+ */
+void Rfm9x::setLoraMode(const bool lora) {
+    if (lora == isLora())
+        return;
+
+    stopContinuous();
+    writeReg(RegOpMode, opMode | MODE_SLEEP); // LongRangeMode can be changed in sleep mode only
+    opMode = (lora ? 1<<7 : modulation << 5) | (opMode & (1<<3));
+    setMode(MODE_SLEEP);
+    resyncRegCache();
+    if (lora) {
+        static const uint8_t UNCACHED[] = {RegOpMode, RegLoraFifoAddrPtr, RegLoraIrqFlags};
+        setUncachedRegs(UNCACHED, sizeof(UNCACHED));
+    }
+    else {
+        setUncachedFsk();
+        writeFskConfig();
+    }
+}
+
+/**
+ * @brief command and status registers of the FSK / OOK modem, see RfmBase::setUncachedRegs()
+ */
+void Rfm9x::setUncachedFsk() {
+    static const uint8_t UNCACHED[] = {RegOpMode, RegIrqFlags1, RegIrqFlags2};
+    setUncachedRegs(UNCACHED, sizeof(UNCACHED), RegAfcFei, 1<<4 | 1<<1); // AgcStart, AfcClear
+}
+
+/**
+ * @brief FSK / OOK packet mode with fixed or unlimited length, no whitening, no crc
+ * Leaves LoRa mode, the other FSK / OOK settings have to be applied afterwards.
+ */
+void Rfm9x::setModulation(const Modulation modulation) {
+    stopContinuous();
+    this->modulation = modulation;
+    setLoraMode(false);
+    opMode = (opMode & ~(3<<5)) | modulation << 5;
+    setMode(MODE_STDBY);
+    if (modulation == MODULATION_OOK)
+        setReg(RegOokPeak, 1<<5 | 1<<3, 1<<5 | 3<<3); // bit synchronizer, peak threshold
+    writeReg(RegPacketConfig1, 0x00);
+}
+
+/**
+ * @brief LoRa reception, started with startReceive()
+ * Spreading factor 6 works in implicit header mode only. setModulation() switches back to FSK / OOK.
+ * DIO0 is mapped to RxDone, packets stay in the 256 byte FIFO until the next one is received.
+ */
+bool Rfm9x::setLora(const LoraConfig &cfg) {
+    static const uint32_t BANDWIDTHS[] = {7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000};
+    uint8_t bw = 0;
+    while ( (bw < sizeof(BANDWIDTHS) / sizeof(BANDWIDTHS[0]) - 1) && (BANDWIDTHS[bw] < cfg.bandwidth) )
+        bw++;
+
+    const uint32_t symbolUs = (1000000UL << cfg.spreadingFactor) / BANDWIDTHS[bw];
+    const bool implicit = cfg.implicitLen > 0;
+    const bool sf6 = cfg.spreadingFactor == 6;
+
+    setLoraMode(true);
+    const RfmConfig regs[] = {
+        {RegLoraFifoRxBaseAddr,     0},
+        {RegLoraModemConfig1,       (uint8_t) (bw << 4 | (cfg.codingRate - 4) << 1 | implicit)},
+        {RegLoraModemConfig2,       (uint8_t) (cfg.spreadingFactor << 4 | cfg.crc << 2)},
+        {RegLoraPreambleMsb,        0},
+        {RegLoraPreambleLsb,        8},
+        {RegLoraPayloadLength,      implicit ? cfg.implicitLen : (uint8_t) 0xFF},
+        {RegLoraMaxPayloadLength,   0xFF},
+        {RegLoraModemConfig3,       (uint8_t) ((symbolUs > 16000) << 3 | 1<<2)}, // LowDataRateOptimize above 16 ms symbols, AgcAutoOn
+        {RegLoraDetectOptimize,     (uint8_t) (sf6 ? 0xC5 : 0xC3)},
+        {RegLoraDetectionThreshold, (uint8_t) (sf6 ? 0x0C : 0x0A)},
+        {RegLoraSyncWord,           cfg.syncWord},
+        {RegDioMapping1,            0<<6} // DIO0: RxDone
+    };
+    writeConfig(regs, sizeof(regs) / sizeof(regs[0]));
+    setMode(MODE_STDBY);
+    return true;
+}
+
+void Rfm9x::loop() {
+    if (!modeReady)
+        isModeReady();
+
+    if (isLora())
+        return;
+
+    switch (mode) {
+    case MODE_TX:
+        if ( (pinDio0 != NOPIN) ? dio0Flag : ((readReg(RegIrqFlags2) & (1<<3)) != 0) ) // PacketSent
+            setMode(MODE_STDBY);
+        break;
+
+    case MODE_RX:
+        if ( !rssiflag && ((readReg(RegIrqFlags1) & (1<<0)) != 0) ) { // Sync address match
+            rssi = -readReg(RegRssiValue) / 2;
+            fei = (int16_t) readReg16(RegFeiMsb) * FSTEP; // measured on the preamble
+            rssiflag = true;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void Rfm9x::stop() {
+    setMode(MODE_STDBY);
+}
+
+/**
+ * @brief select the channel filter, call after setModulation()
+ */
+void Rfm9x::setRxBandwidth(const uint32_t bw_hz) {
+    writeReg(RegRxBw, rxBwValue(bw_hz, modulation == MODULATION_OOK));
+}
+
+/**
+ * @param thresh RSSI threshold to start reception in -0.5 dBm
+ */
+void Rfm9x::setRssiThreshold(const uint8_t thresh) {
+    writeReg(RegRssiThresh, thresh);
+}
+
+void Rfm9x::setPreamble(const uint16_t len) {
+    writeReg16(RegPreambleMsb, len);
+}
+
+/**
+ * @brief FifoLevel threshold, transmission starts with the first byte in the FIFO
+ */
+void Rfm9x::setFifoThreshold(const uint8_t thresh) {
+    writeReg(RegFifoThresh, 1<<7 | thresh);
+}
+
+/**
+ * @brief syncsize 0: no sync word, the FIFO is filled from the start of reception
+ */
+void Rfm9x::setSync(const uint8_t *sync, const int syncsize) {
+    uint8_t sc = readRegCached(RegSyncConfig) & ~(1<<4 | 7<<0);
+    if (syncsize > 0) {
+        sc |= 1<<4 | (syncsize - 1);
+        writeRegBuf(RegSyncValue1, sync, syncsize);
+    }
+    writeReg(RegSyncConfig, sc);
+}
+
+/**
+ * @brief set output power on PA_BOOST
+ * 
+ * @param power +2..+20 dBm
+ */
+void Rfm9x::setTxPower(const int8_t power) {
+    const int8_t pwr = constrain(power, 2, 20);
+    if (pwr > 17) {
+        writeReg(RegPaDac, 0x87); // +20 dBm mode
+        writeReg(RegOcp, 1<<5 | 18); // 150 mA
+        writeReg(RegPaConfig, 1<<7 | 7<<4 | (pwr - 5));
+    }
+    else {
+        writeReg(RegPaDac, 0x84); // normal mode
+        writeReg(RegOcp, 1<<5 | 11); // 100 mA
+        writeReg(RegPaConfig, 1<<7 | 7<<4 | (pwr - 2));
+    }
+}
+
+/**
+ * @brief set carrier frequency, LowFrequencyModeOn is selected below 525 MHz (RFM96 / RFM98)
+ */
+void Rfm9x::setFreq(const uint32_t freq_hz) {
+    const uint8_t lf = (freq_hz < 525000000UL) ? 1<<3 : 0;
+    if ((opMode & (1<<3)) != lf) {
+        opMode ^= 1<<3;
+        writeReg(RegOpMode, opMode | mode);
+    }
+
+    uint32_t fword = (freq_hz / FSTEP) + f_corr;
+    const uint8_t buf[] = {(uint8_t) (fword >> 16), (uint8_t) (fword >> 8), (uint8_t) fword};
+    writeRegBuf(RegFrfMsb, buf, sizeof(buf));
+}
+
+void Rfm9x::setBitrate(const uint16_t bit_s) {
+    uint16_t br_word = 32E06 / bit_s;
+    writeReg16(RegBitrateMsb, br_word);
+}
+
+bool Rfm9x::isIdle() {
+    return (mode != MODE_TX) && (mode != MODE_RX);
+}
+
+bool Rfm9x::payloadReady() {
+    if (isLora()) {
+        if ( (mode != MODE_RX) || ((pinDio0 != NOPIN) && !dio0Flag) )
+            return false;
+
+        const uint8_t flags = readReg(RegLoraIrqFlags);
+        if ((flags & (1<<6)) == 0) // RxDone
+            return false;
+
+        if ((flags & (1<<5)) != 0) { // PayloadCrcError
+            crcErrors++;
+            dio0Flag = false; // RxDone drops with the flags
+            writeReg(RegLoraIrqFlags, 0xFF);
+            return false;
+        }
+        return true;
+    }
+
+    if (pinDio0 != NOPIN)
+        return (mode == MODE_RX) && dio0Flag;
+
+    return (readReg(RegIrqFlags2) & (1<<2)) != 0;
+}
+
+/**
+ * @brief FSK / OOK only, LoRa is receive only
+ */
+void Rfm9x::send(const uint8_t *data, const int size, const bool varSize) {
+    if (isLora())
+        return;
+
+    setMode(MODE_STDBY);
+    stopContinuous();
+    writeReg(RegIrqFlags2, 1<<4); // FifoOverrun, clears the FIFO
+    if (varSize) { //variable length
+        setReg(RegPacketConfig1, 1<<7, 1<<7);  // set PacketFormat
+        writeReg(RegFifo, (uint8_t) size);
+    }
+    else { //fixed length
+        setReg(RegPacketConfig1, 0<<7, 1<<7); // unset PacketFormat
+        writeReg(RegPayloadLength, size);
+    }
+
+    writeRegBuf(RegFifo, data, size);
+    dio0Flag = false; // PacketSent is low in standby
+    setMode(MODE_TX);
+}
+
+void Rfm9x::writeFifo(const uint8_t *buf, uint8_t size) {
+    writeRegBuf(RegFifo, buf, size);
+}
+
+void Rfm9x::txTest(const uint32_t freq_hz, const int16_t f_corr, const int8_t pwr, const uint16_t baud) {
+    setModulation(MODULATION_OOK);
+    setPreamble(15000);
+    this->f_corr = f_corr;
+    setFreq(freq_hz);
+    setTxPower(pwr);
+    setBitrate(baud);
+
+    uint8_t data[] = {0x55};
+    send(data, sizeof(data), false);
+}
+
+/**
+ * @brief set RFM in receive mode
+ * 
+ * @param size -1: variable packet len, ignored in LoRa mode
+ */
+void Rfm9x::startReceive(const int size) {
+    fei = 0;
+    if (isLora()) {
+        setMode(MODE_STDBY);
+        writeReg(RegLoraFifoAddrPtr, 0);
+        writeReg(RegLoraIrqFlags, 0xFF);
+        dio0Flag = false;
+        setMode(MODE_RX);
+        return;
+    }
+
+    setMode(MODE_FSRX);
+    stopContinuous();
+    writeReg(RegIrqFlags2, 1<<4); // FifoOverrun, clears the FIFO
+    rxSize = size;
+    rssiflag = false;
+
+    if (size == -1) {
+        // variable length, packet engine will read 1st byte of payload as len
+        setReg(RegPacketConfig1, 1<<7, 1<<7);
+        writeReg(RegPayloadLength, 255);
+    }
+    else {
+        // fixed or unlimited length (size == 0)
+        setReg(RegPacketConfig1, 0<<7, 1<<7);
+        writeReg(RegPayloadLength, size);
+    }
+    dio0Flag = false; // the FIFO was cleared, PayloadReady is low
+    setMode(MODE_RX);
+}
+
+/**
+ * @brief reads the received LoRa packet, RSSI and SNR
+ * In continuous reception the packet starts at FifoRxCurrentAddr, not at FifoRxBaseAddr.
+ */
+uint8_t Rfm9x::getLoraPayload(uint8_t *buf, const uint8_t maxlen) {
+    uint8_t len = readReg(RegLoraRxNbBytes);
+    if (len > maxlen)
+        len = maxlen;
+    writeReg(RegLoraFifoAddrPtr, readReg(RegLoraFifoRxCurrentAddr));
+    readFifo(buf, len);
+
+    snr = (int8_t) readReg(RegLoraPktSnrValue) / 4;
+    int16_t pktRssi = (((opMode & (1<<3)) != 0) ? -164 : -157) + readReg(RegLoraPktRssiValue);
+    if (snr < 0)
+        pktRssi += snr;
+    rssi = pktRssi;
+
+    dio0Flag = false;
+    writeReg(RegLoraIrqFlags, 0xFF);
+    return len;
+}
+
+/**
+ * @param buf must hold 255 bytes in LoRa mode
+ */
+uint8_t Rfm9x::getPayload(uint8_t *buf) {
+    if (isLora())
+        return getLoraPayload(buf, 255);
+
+    uint8_t result;
+    if (rxSize == -1) {
+        // variable packet size
+        result = readReg(RegFifo);
+    }
+    else
+        result = rxSize;
+
+    readFifo(buf, result);
+    return result;
+}
+
+uint8_t Rfm9x::getPayload(uint8_t *buf, const uint8_t maxlen) {
+    if (isLora())
+        return payloadReady() ? getLoraPayload(buf, maxlen) : 0;
+
+    uint8_t result = 0;
+    auto iq2 = readReg(RegIrqFlags2);
+    if ((iq2 & (1<<4)) != 0) { // FifoOverrun
+        fifoOverruns++;
+        writeReg(RegIrqFlags2, 1<<4); // clears the flag and the FIFO, the samples in it are not contiguous
+        return 0;
+    }
+    const uint8_t burst = (readRegCached(RegFifoThresh) & 0x3F) + 1;
+    if ( ((iq2 & (1<<5)) != 0) && (burst <= maxlen) ) { // FifoLevel
+        readFifo(buf, burst);
+        result = burst;
+        iq2 = readReg(RegIrqFlags2);
+    }
+    while ( ((iq2 & (1<<6)) == 0) && (result < maxlen) )  { // FIFO not empty
+        buf[result++] = readReg(RegFifo);
+        iq2 = readReg(RegIrqFlags2);
+    }
+    return result;
+}
+
+int8_t Rfm9x::getRssi() {
+    return rssi;
+}
+
+Rfm9x::FifoLevel Rfm9x::getFifoLevel() {
+    uint8_t iq2 = readReg(RegIrqFlags2);
+
+    if ( (iq2 & (1<<6)) != 0 )
+        return FIFO_EMPTY;
+
+    if ( (iq2 & (1<<7)) != 0 )
+        return FIFO_FULL;
+
+    if ( (iq2 & (1<<5)) != 0 )
+        return FIFO_THRESH;
+
+    return FIFO_NOTEMPTY;
+}
+
+/**
+ * @brief set RFM in continuous receive mode, see Rfm69::startReceiveContinuous()
+ * 
+ * @return false if DIO2 is not connected or in LoRa mode
+ */
+bool Rfm9x::startReceiveContinuous() {
+    if ( (pinDio2 == NOPIN) || isLora() )
+        return false;
+
+    setMode(MODE_FSRX);
+    setReg(RegPacketConfig2, 0<<6, 1<<6); // continuous mode
+    setReg(RegOokPeak, 0<<5, 1<<5); // without bit synchronizer
+    startEdgeCapture();
+    setMode(MODE_RX);
+    return true;
+}
+
+/**
+ * @brief back to packet mode
+ */
+void Rfm9x::stopContinuous() {
+    if (stopEdgeCapture()) {
+        setReg(RegPacketConfig2, 1<<6, 1<<6);
+        setReg(RegOokPeak, 1<<5, 1<<5);
+    }
+}
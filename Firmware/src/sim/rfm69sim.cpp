@@ -0,0 +1,642 @@
+#include "rfm69sim.h"
+
+static const int8_t NOISERSSI = -110; // dBm without signal
+static const double FSTEP = 32E6 / (1UL<<19);
+
+Rfm69Sim::Rfm69Sim(const uint8_t pinSS, const uint8_t pinDio0, const uint8_t pinDio2):
+        pinSS(pinSS),
+        pinDio0(pinDio0),
+        pinDio2(pinDio2),
+        addrPhase(true),
+        writeAccess(false),
+        addr(0),
+        fifoHead(0),
+        fifoLen(0),
+        fifoOverrun(false),
+        mode(MODE_STDBY),
+        readyNs(NEVER),
+        hangArmed(false),
+        hung(false),
+        restoring(false),
+        simNs((uint64_t) micros() * 1000),
+        advancing(false),
+        rxState(RX_OFF),
+        rxNextNs(NEVER),
+        syncShift(0),
+        syncBits(0),
+        rxByte(0),
+        rxBits(0),
+        rxRemaining(0),
+        syncMatch(false),
+        payloadReady(false),
+        txStarted(false),
+        txStarved(false),
+        txLength(false),
+        txLast(false),
+        txRemaining(0),
+        txNextNs(NEVER),
+        packetSent(false),
+        noise(0xACE1),
+        dio0Level(LOW),
+        dio2Level(LOW) {
+    resetRegisters();
+    resetStats();
+    mockPinHook(pinSS, csHook, this);
+    mockTimeHook(timeHook, this);
+}
+
+Rfm69Sim::~Rfm69Sim() {
+    mockPinHook(pinSS, nullptr, nullptr);
+    mockTimeHook(nullptr, this);
+}
+
+void Rfm69Sim::resetRegisters() {
+    memset(regs, 0, sizeof(regs));
+    regs[0x01] = MODE_STDBY << 2;
+    regs[0x03] = 0x1A; // 4.8 kbit/s
+    regs[0x04] = 0x0B;
+    regs[0x06] = 0x52;
+    regs[0x07] = 0xE4;
+    regs[0x08] = 0xC0;
+    regs[0x10] = 0x24; // RegVersion
+    regs[0x11] = 0x9F;
+    regs[0x13] = 0x1A;
+    regs[0x18] = 0x08;
+    regs[0x19] = 0x86;
+    regs[0x1A] = 0x8A;
+    regs[0x26] = 0x07;
+    regs[0x29] = 0xE4;
+    regs[0x2D] = 0x03;
+    regs[0x2E] = 0x98;
+    for (uint8_t i=0; i<8; i++)
+        regs[0x2F + i] = 0x01;
+    regs[0x37] = 0x10;
+    regs[0x38] = 0x40;
+    regs[0x3C] = 0x8F;
+    regs[0x3D] = 0x02;
+}
+
+void Rfm69Sim::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief queues RF input, it starts after the previously queued input or now
+ *
+ * @param data bits, MSB first. OOK: carrier on / off, FSK: demodulated data
+ * @param rssi level of the carrier
+ * @param gapUs time without signal in front of the data
+ * @param offsetHz carrier offset of the transmitter from RegFrf at the time of the call
+ */
+void Rfm69Sim::queueRx(const uint8_t *data, const uint32_t bits, const uint32_t bitrate, const int8_t rssi, const uint32_t gapUs, const int32_t offsetHz) {
+    Segment s;
+    s.startNs = (uint64_t) micros() * 1000;
+    if (!rf.empty() && (rf.back().endNs() > s.startNs))
+        s.startNs = rf.back().endNs();
+    s.startNs += (uint64_t) gapUs * 1000;
+    s.bitNs = 1000000000ULL / bitrate;
+    s.data.assign(data, data + (bits + 7) / 8);
+    s.bits = bits;
+    s.rssi = rssi;
+    s.freqHz = frf() + offsetHz;
+    rf.push_back(s);
+}
+
+/**
+ * @return micros() at the end of the queued RF input
+ */
+unsigned long Rfm69Sim::getRxEnd() const {
+    if (rf.empty())
+        return micros();
+    return rf.back().endNs() / 1000;
+}
+
+/**
+ * @brief the next mode request loses all register values and never gets ready, until standby is
+ * requested
+ */
+void Rfm69Sim::hangSequencer() {
+    hangArmed = true;
+}
+
+/**
+ * @brief processes everything up to now, call while the driver does not access the chip
+ */
+void Rfm69Sim::update() {
+    advance((uint64_t) micros() * 1000);
+    updateDio();
+}
+
+void Rfm69Sim::csHook(void *arg, uint8_t val) {
+    Rfm69Sim *sim = static_cast<Rfm69Sim*>(arg);
+    sim->advance((uint64_t) micros() * 1000);
+    if (val == LOW) {
+        sim->addrPhase = true;
+        sim->stats.spiTransactions++;
+    }
+    else
+        sim->updateDio();
+}
+
+void Rfm69Sim::timeHook(void *arg) {
+    Rfm69Sim *sim = static_cast<Rfm69Sim*>(arg);
+    sim->advance((uint64_t) micros() * 1000);
+}
+
+uint8_t Rfm69Sim::transfer(uint8_t data) {
+    stats.spiBytes++;
+    if (addrPhase) {
+        addrPhase = false;
+        addr = data & 0x7F;
+        writeAccess = (data & 0x80) != 0;
+        stats.regTransactions[addr]++;
+        return 0;
+    }
+
+    uint8_t result = 0;
+    if (writeAccess) {
+        if (restoring && isCommand(addr, data))
+            stats.restoreCommands++;
+        writeRegister(addr, data);
+    }
+    else
+        result = readRegister(addr);
+    if (addr != 0) // FIFO is accessed repeatedly in bursts
+        addr = (addr + 1) & 0x7F;
+    return result;
+}
+
+uint64_t Rfm69Sim::bitNs() const {
+    const uint16_t br = regs[0x03] << 8 | regs[0x04];
+    return (br > 0) ? br * 1000ULL / 32 : 1; // FXOSC 32 MHz
+}
+
+/**
+ * @brief carrier frequency in Hz
+ */
+double Rfm69Sim::frf() const {
+    return (regs[0x07] << 16 | regs[0x08] << 8 | regs[0x09]) * FSTEP;
+}
+
+/**
+ * @brief single side bandwidth of the channel filter in Hz
+ */
+uint32_t Rfm69Sim::rxBw() const {
+    const uint8_t mant = 16 + 4 * ((regs[0x19] >> 3) & 3);
+    const uint8_t exp = regs[0x19] & 7;
+    return 32000000UL / ((uint32_t) mant << (exp + (isOok() ? 3 : 2)));
+}
+
+/**
+ * @brief processes receiver, transmitter and mode transitions in time order up to untilNs
+ */
+void Rfm69Sim::advance(const uint64_t untilNs) {
+    if (advancing) // chip accessed from an interrupt handler
+        return;
+    advancing = true;
+
+    while (true) {
+        uint64_t t = NEVER;
+        if (!isReady())
+            t = readyNs;
+        else if (mode == MODE_RX)
+            t = isContinuous() ? nextRfBoundary(simNs) : rxNextNs;
+        else if ( (mode == MODE_TX) && txStarted )
+            t = txNextNs;
+        if (t > untilNs)
+            break;
+
+        simNs = t;
+        if (!isReady())
+            onModeReady();
+        else if (mode == MODE_RX) {
+            if (isContinuous()) {
+                dio2Level = (rfLevel(t) > 0) ? HIGH : LOW;
+                mockPinInput(pinDio2, dio2Level, t / 1000);
+            }
+            else {
+                const int level = rfLevel(t);
+                rxBit((level < 0) ? (!isOok() && noiseBit()) : (level > 0));
+                rxNextNs += bitNs();
+            }
+        }
+        else
+            txSlot();
+        updateDio();
+    }
+
+    if (untilNs > simNs)
+        simNs = untilNs;
+    advancing = false;
+}
+
+/**
+ * @brief RF input at time t, segments which are over are dropped
+ *
+ * @param rssi level of the carrier, NOISERSSI if it is off
+ * @return -1: no input, else the bit
+ */
+int Rfm69Sim::rfLevel(const uint64_t t, int8_t *rssi) {
+    while (!rf.empty() && (rf.front().endNs() <= t))
+        rf.pop_front();
+
+    if (rssi != nullptr)
+        *rssi = NOISERSSI;
+    if (rf.empty() || (t < rf.front().startNs))
+        return -1;
+
+    const Segment &s = rf.front();
+    if (fabs(s.freqHz - frf()) > rxBw()) // outside the channel filter
+        return -1;
+
+    const uint32_t i = (t - s.startNs) / s.bitNs;
+    const int bit = (s.data[i >> 3] >> (7 - (i & 7))) & 1;
+    if ( (rssi != nullptr) && ((bit != 0) || !isOok()) )
+        *rssi = s.rssi;
+    return bit;
+}
+
+/**
+ * @return next bit boundary of the RF input after the given time, NEVER if there is no input
+ */
+uint64_t Rfm69Sim::nextRfBoundary(const uint64_t after) {
+    for (const Segment &s : rf) {
+        if (s.endNs() <= after)
+            continue;
+        if (after < s.startNs)
+            return s.startNs;
+        return s.startNs + ((after - s.startNs) / s.bitNs + 1) * s.bitNs;
+    }
+    return NEVER;
+}
+
+bool Rfm69Sim::noiseBit() {
+    noise = (noise >> 1) ^ (-(noise & 1) & 0xB400);
+    return (noise & 1) != 0;
+}
+
+/**
+ * @brief starts a transition, typical times of the datasheet until ModeReady
+ */
+void Rfm69Sim::setMode(const Mode newMode) {
+    if (hangArmed) {
+        hangArmed = false;
+        hung = true;
+        const uint8_t opMode = regs[0x01];
+        resetRegisters();
+        regs[0x01] = opMode;
+    }
+    if (hung && (newMode == MODE_STDBY)) {
+        hung = false;
+        restoring = true;
+    }
+    else if (newMode != MODE_STDBY)
+        restoring = false;
+
+    if (newMode == mode)
+        return;
+
+    if (mode == MODE_RX) {
+        rxState = RX_OFF;
+        syncMatch = false;
+        payloadReady = false;
+        if (dio2Level != LOW) {
+            dio2Level = LOW;
+            mockPinInput(pinDio2, LOW, simNs / 1000);
+        }
+    }
+    else if (mode == MODE_TX) {
+        txStarted = false;
+        packetSent = false;
+    }
+
+    uint32_t us = 0;
+    switch (newMode) {
+    case MODE_SLEEP:
+        us = 10;
+        break;
+    case MODE_STDBY:
+        us = (mode == MODE_SLEEP) ? 250 : 10;
+        break;
+    case MODE_FS:
+        us = (mode == MODE_SLEEP) ? 310 : 60;
+        break;
+    case MODE_TX:
+        us = ((mode < MODE_FS) ? 60 : 0) + 50;
+        break;
+    case MODE_RX:
+        us = ((mode < MODE_FS) ? 60 : 0) + 100;
+        break;
+    }
+    mode = newMode;
+    readyNs = hung ? NEVER - 1 : simNs + us * 1000ULL;
+}
+
+void Rfm69Sim::onModeReady() {
+    readyNs = NEVER;
+    if (mode == MODE_RX)
+        startRx();
+    else if (mode == MODE_TX) {
+        txStarved = false;
+        txLast = false;
+        packetSent = false;
+        txLength = (regs[0x37] & (1<<7)) != 0;
+        txRemaining = txLength ? 0 : regs[0x38];
+        checkTxStart();
+    }
+}
+
+void Rfm69Sim::startRx() {
+    clearFifo();
+    if (isContinuous()) {
+        rxState = RX_OFF;
+        dio2Level = (rfLevel(simNs) > 0) ? HIGH : LOW;
+        mockPinInput(pinDio2, dio2Level, simNs / 1000);
+        return;
+    }
+
+    rxNextNs = simNs + bitNs() / 2;
+    restartRx();
+}
+
+void Rfm69Sim::restartRx() {
+    syncMatch = false;
+    payloadReady = false;
+    syncShift = 0;
+    syncBits = 0;
+    if ((regs[0x2E] & (1<<6)) != 0) // FifoFillCondition always
+        startPayload();
+    else
+        rxState = RX_SYNC;
+}
+
+void Rfm69Sim::startPayload() {
+    rxBits = 0;
+    if ((regs[0x37] & (1<<7)) != 0) // variable length
+        rxState = RX_LENGTH;
+    else {
+        rxState = RX_PAYLOAD;
+        rxRemaining = regs[0x38];
+    }
+}
+
+void Rfm69Sim::rxBit(const bool bit) {
+    switch (rxState) {
+    case RX_SYNC: {
+        if ((regs[0x2E] & (1<<7)) == 0) // no sync word and no FifoFillCondition, nothing is received
+            break;
+
+        syncShift = syncShift << 1 | bit;
+        if (syncBits < 64)
+            syncBits++;
+        const uint8_t len = ((regs[0x2E] >> 3) & 7) + 1;
+        if (syncBits < len * 8)
+            break;
+
+        uint64_t word = 0;
+        for (uint8_t i=0; i<len; i++)
+            word = word << 8 | regs[0x2F + i];
+        const uint64_t mask = (len == 8) ? ~0ULL : (1ULL << (len * 8)) - 1;
+        if ((syncShift & mask) == word) {
+            syncMatch = true;
+            stats.syncMatches++;
+            startPayload();
+        }
+        break;
+    }
+
+    case RX_LENGTH:
+    case RX_PAYLOAD:
+        rxByte = rxByte << 1 | bit;
+        if (++rxBits < 8)
+            break;
+        rxBits = 0;
+        pushFifo(rxByte);
+
+        if (rxState == RX_LENGTH) {
+            rxState = RX_PAYLOAD;
+            rxRemaining = rxByte;
+            if (rxRemaining > 0)
+                break;
+        }
+        else if ( (rxRemaining == 0) || (--rxRemaining > 0) ) // unlimited or more bytes to come
+            break;
+
+        rxState = RX_DONE;
+        payloadReady = true;
+        stats.payloadsReady++;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief TxStartCondition: FIFO not empty or FifoLevel above threshold
+ */
+void Rfm69Sim::checkTxStart() {
+    if ( (mode != MODE_TX) || !isReady() || txStarted || packetSent )
+        return;
+
+    const bool notEmpty = (regs[0x3C] & (1<<7)) != 0;
+    if ( notEmpty ? (fifoLen > 0) : (fifoLen > (regs[0x3C] & 0x7F)) ) {
+        txStarted = true;
+        txNextNs = simNs;
+    }
+}
+
+/**
+ * @brief next byte moves from the FIFO to the modulator
+ */
+void Rfm69Sim::txSlot() {
+    txNextNs += 8 * bitNs();
+    if (txLast) {
+        txStarted = false;
+        packetSent = true;
+        stats.packetsSent++;
+        return;
+    }
+
+    if (fifoLen == 0) {
+        txStarved = true;
+        return;
+    }
+
+    const uint8_t data = popFifo();
+    txData.push_back(data);
+    if (txLength) {
+        txLength = false;
+        txRemaining = data;
+        txLast = (data == 0);
+    }
+    else if (txRemaining > 0)
+        txLast = (--txRemaining == 0);
+}
+
+void Rfm69Sim::pushFifo(const uint8_t data) {
+    if (fifoLen == FIFOSIZE) {
+        fifoOverrun = true;
+        stats.fifoOverruns++;
+        return;
+    }
+    fifo[(fifoHead + fifoLen) % FIFOSIZE] = data;
+    fifoLen++;
+}
+
+uint8_t Rfm69Sim::popFifo() {
+    if (fifoLen == 0)
+        return 0;
+
+    const uint8_t data = fifo[fifoHead];
+    fifoHead = (fifoHead + 1) % FIFOSIZE;
+    fifoLen--;
+    if ( (fifoLen == 0) && (rxState == RX_DONE) ) {
+        if ((regs[0x3D] & (1<<1)) != 0) // AutoRxRestartOn
+            restartRx();
+        else {
+            syncMatch = false;
+            payloadReady = false;
+        }
+    }
+    return data;
+}
+
+void Rfm69Sim::clearFifo() {
+    fifoHead = 0;
+    fifoLen = 0;
+    fifoOverrun = false;
+}
+
+uint8_t Rfm69Sim::readRegister(const uint8_t reg) {
+    switch (reg) {
+    case 0x00: // RegFifo
+        return popFifo();
+
+    case 0x24: { // RegRssiValue
+        int8_t rssi;
+        rfLevel(simNs, &rssi);
+        return -2 * rssi;
+    }
+
+    case 0x27: { // RegIrqFlags1
+        uint8_t flags = 0;
+        if (isReady()) {
+            flags |= 1<<7; // ModeReady
+            if (mode == MODE_RX)
+                flags |= 1<<6;
+            if (mode == MODE_TX)
+                flags |= 1<<5;
+            if (mode >= MODE_FS)
+                flags |= 1<<4; // PllLock
+        }
+        if (syncMatch)
+            flags |= 1<<0;
+        return flags;
+    }
+
+    case 0x28: { // RegIrqFlags2
+        uint8_t flags = 0;
+        if (fifoLen == FIFOSIZE)
+            flags |= 1<<7;
+        if (fifoLen > 0)
+            flags |= 1<<6;
+        if (fifoLen > (regs[0x3C] & 0x7F))
+            flags |= 1<<5;
+        if (fifoOverrun)
+            flags |= 1<<4;
+        if (packetSent)
+            flags |= 1<<3;
+        if (payloadReady)
+            flags |= 1<<2;
+        return flags;
+    }
+
+    default:
+        return regs[reg];
+    }
+}
+
+void Rfm69Sim::writeRegister(const uint8_t reg, const uint8_t value) {
+    switch (reg) {
+    case 0x00: // RegFifo
+        pushFifo(value);
+        if (txStarted && txStarved) {
+            stats.txUnderruns++;
+            txStarved = false;
+        }
+        checkTxStart();
+        break;
+
+    case 0x01: { // RegOpMode
+        regs[reg] = value & (7<<2);
+        const uint8_t m = (value >> 2) & 7;
+        setMode((m <= MODE_RX) ? (Mode) m : MODE_STDBY);
+        break;
+    }
+
+    case 0x1E: // RegAfcFei, FeiStart measures the offset of the RF input at once
+        regs[reg] = value & ~(1<<5 | 1<<6);
+        if ( ((value & (1<<5)) != 0) && (mode == MODE_RX) && (rfLevel(simNs) >= 0) ) {
+            const int16_t fei = lround((rf.front().freqHz - frf()) / FSTEP);
+            regs[0x21] = fei >> 8;
+            regs[0x22] = fei;
+            regs[reg] |= 1<<6; // FeiDone
+        }
+        break;
+
+    case 0x28: // RegIrqFlags2, writing FifoOverrun clears the FIFO
+        if ((value & (1<<4)) != 0)
+            clearFifo();
+        break;
+
+    case 0x10: // read only
+    case 0x24:
+    case 0x27:
+        break;
+
+    default:
+        regs[reg] = value;
+        break;
+    }
+}
+
+/**
+ * @brief writes which trigger an action instead of configuring, mode requests aside
+ */
+bool Rfm69Sim::isCommand(const uint8_t reg, const uint8_t value) {
+    switch (reg) {
+    case 0x1E: // RegAfcFei
+        return (value & (1<<5 | 1<<1 | 1<<0)) != 0; // FeiStart, AfcClear, AfcStart
+    case 0x27: // RegIrqFlags1 / 2, flags are cleared
+    case 0x28:
+        return value != 0;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief DIO0 according to RegDioMapping1 in RX / TX, an edge runs the attached interrupt handler
+ */
+void Rfm69Sim::updateDio() {
+    const uint8_t mapping = regs[0x25] >> 6;
+    uint8_t level = LOW;
+    if (mode == MODE_RX) {
+        if (mapping == 1)
+            level = payloadReady;
+        else if (mapping == 2)
+            level = syncMatch;
+    }
+    else if (mode == MODE_TX) {
+        if (mapping == 0)
+            level = packetSent;
+        else if (mapping == 1)
+            level = isReady();
+    }
+
+    if (level != dio0Level) {
+        dio0Level = level;
+        mockPinInput(pinDio0, level, simNs / 1000);
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <Arduino.h>
+#include <SPI.h>
+#include <deque>
+#include <vector>
+
+/**
+ * @brief register-level model of an RFM69 on the mock SPI bus and GPIOs, for host runs of the
+ * real driver and the applications
+ *
+ * Modelled are the register file, mode transitions with ModeReady delay, the 66 byte FIFO with
+ * threshold / full / overrun flags, the packet engine for fixed, variable and unlimited length
+ * with sync word detection, DIO0 mapping and the demodulated data on DIO2 in continuous mode.
+ * FEI reports the carrier offset of the RF input, input outside the channel filter (RegRxBw) is
+ * not received. Not modelled: CRC, AES, whitening, AFC, RSSI threshold and timeouts.
+ * hangSequencer() injects a brownout during a mode transition, for the driver's recovery. Commands
+ * like FeiStart written while it restores the registers are counted, they must not be replayed.
+ *
+ * RF input is a scripted bitstream queued with queueRx(). The receiver samples it in the middle
+ * of its own bit periods (RegBitrate), in continuous mode the edges are put out on DIO2 as they
+ * are. The state is advanced to micros() whenever it is read, on every chipselect and by update(),
+ * events in between are processed in time order with micros() of the event for interrupt handlers.
+ * The FIFO is cleared when RX starts.
+ */
+class Rfm69Sim: public SPIDevice {
+public:
+    static const uint8_t FIFOSIZE = 66;
+
+    struct Stats {
+        uint32_t spiTransactions;
+        uint32_t spiBytes;
+        uint32_t regTransactions[0x80]; // by start address of the transaction
+        uint32_t fifoOverruns; // received bytes lost, FIFO was full
+        uint32_t txUnderruns; // FIFO ran empty during TX and was refilled afterwards
+        uint32_t syncMatches;
+        uint32_t payloadsReady;
+        uint32_t packetsSent;
+        uint32_t restoreCommands; // commands written after a hang ended, until another mode than standby is requested
+    };
+
+    Rfm69Sim(const uint8_t pinSS, const uint8_t pinDio0, const uint8_t pinDio2);
+    ~Rfm69Sim();
+
+    void queueRx(const uint8_t *data, const uint32_t bits, const uint32_t bitrate, const int8_t rssi = -60, const uint32_t gapUs = 0, const int32_t offsetHz = 0);
+    unsigned long getRxEnd() const;
+    void update();
+    void hangSequencer();
+
+    const Stats &getStats() const { return stats; }
+    void resetStats();
+    const std::vector<uint8_t> &getTxData() const { return txData; }
+    void clearTxData() { txData.clear(); }
+
+    uint8_t transfer(uint8_t data);
+
+private:
+    enum Mode: uint8_t {
+        MODE_SLEEP = 0,
+        MODE_STDBY = 1,
+        MODE_FS = 2,
+        MODE_TX = 3,
+        MODE_RX = 4
+    };
+
+    enum RxState: uint8_t {
+        RX_OFF,
+        RX_SYNC, // waiting for sync word
+        RX_LENGTH, // variable length, next byte is the length
+        RX_PAYLOAD,
+        RX_DONE // PayloadReady, waiting for the FIFO to be emptied
+    };
+
+    struct Segment {
+        uint64_t startNs;
+        uint64_t bitNs;
+        std::vector<uint8_t> data; // MSB first
+        uint32_t bits;
+        int8_t rssi;
+        double freqHz; // carrier of the transmitter
+        uint64_t endNs() const { return startNs + bits * bitNs; }
+    };
+
+    static const uint64_t NEVER = ~0ULL;
+
+    uint8_t pinSS;
+    uint8_t pinDio0;
+    uint8_t pinDio2;
+    uint8_t regs[0x80];
+
+    bool addrPhase; // next byte on the bus is an address
+    bool writeAccess;
+    uint8_t addr;
+
+    uint8_t fifo[FIFOSIZE];
+    uint8_t fifoHead;
+    uint8_t fifoLen;
+    bool fifoOverrun;
+
+    Mode mode;
+    uint64_t readyNs; // time of ModeReady, NEVER if ready
+    bool hangArmed; // next mode request hangs
+    bool hung; // no ModeReady until standby is requested
+    bool restoring; // standby ended a hang, the driver rewrites the registers
+    uint64_t simNs; // state is advanced up to here
+    bool advancing;
+
+    RxState rxState;
+    uint64_t rxNextNs; // next sampling point
+    uint64_t syncShift;
+    uint8_t syncBits;
+    uint8_t rxByte;
+    uint8_t rxBits;
+    uint16_t rxRemaining; // bytes until PayloadReady, 0: unlimited
+    bool syncMatch;
+    bool payloadReady;
+
+    bool txStarted;
+    bool txStarved; // FIFO was empty at the last byte slot
+    bool txLength; // variable length, next byte is the length
+    bool txLast; // last byte of the packet is being sent
+    uint16_t txRemaining; // bytes until PacketSent, 0: unlimited
+    uint64_t txNextNs;
+    bool packetSent;
+
+    std::deque<Segment> rf;
+    uint32_t noise; // LFSR, FSK receiver output without signal
+    uint8_t dio0Level;
+    uint8_t dio2Level;
+    Stats stats;
+    std::vector<uint8_t> txData;
+
+    static void csHook(void *arg, uint8_t val);
+    static void timeHook(void *arg);
+    bool isReady() const { return readyNs == NEVER; }
+    void resetRegisters();
+    bool isContinuous() const { return (regs[0x02] & (3<<5)) != 0; }
+    bool isOok() const { return (regs[0x02] & (3<<3)) == (1<<3); }
+    uint64_t bitNs() const;
+    uint32_t rxBw() const;
+    double frf() const;
+    void advance(const uint64_t untilNs);
+    int rfLevel(const uint64_t t, int8_t *rssi = nullptr);
+    uint64_t nextRfBoundary(const uint64_t after);
+    void setMode(const Mode newMode);
+    void onModeReady();
+    void startRx();
+    void restartRx();
+    void startPayload();
+    bool noiseBit();
+    void rxBit(const bool bit);
+    void checkTxStart();
+    void txSlot();
+    void pushFifo(const uint8_t data);
+    uint8_t popFifo();
+    void clearFifo();
+    uint8_t readRegister(const uint8_t reg);
+    void writeRegister(const uint8_t reg, const uint8_t value);
+    static bool isCommand(const uint8_t reg, const uint8_t value);
+    void updateDio();
+};
@@ -0,0 +1,518 @@
+/**
+ * @brief real-time run of the RFM69 driver and the applications against the register-level
+ * simulation in rfm69sim.h, the Rfm9x driver against sx127xsim.h at the end
+ * Build and run with: pio run -e sim -t exec
+ * Recorded frames are put on air back to back while the main loop runs like on the gateway. Per
+ * frame the decodes, SPI transactions and bytes and the bus time are reported, overruns show
+ * that the loop did not keep up with the receiver. micros() runs in real time plus the simulated
+ * bus time, so the host's speed sets the loop rate between SPI accesses.
+ */
+#include <algorithm>
+#include <vector>
+#include <stdio.h>
+#include "main.h"
+#include "applications/rc433.h"
+#include "applications/868gw.h"
+#include "applications/lora.h"
+#include "../bench/recordings.h"
+#include "rfm69sim.h"
+#include "sx127xsim.h"
+
+PubSubClient mqtt;
+AsyncWebSocket ws;
+String baseTopic = F("gw");
+static RfmBase *radio;
+AsyncWebServer websrv;
+
+const uint32_t FRAMES = 10; // frames per recording
+const uint8_t RCLEADINGGAP = 130; // samples of silence in front of a pulse train
+const uint32_t RCBITRATE = 1000000 / PULSEWIDTHUS;
+const uint32_t GAPUS868 = 10000; // between 868 MHz frames
+const uint32_t TAILUS = 50000; // loop keeps running after the last frame
+
+static const uint8_t PIN_SS = 16;
+static const uint8_t PIN_DIO0 = 9;
+static const uint8_t PIN_DIO2 = 10;
+static const uint8_t PIN_SS2 = 4; // SX127x, second module
+static const uint8_t PIN_DIO0_2 = 5;
+
+static Rfm69Sim sim(PIN_SS, PIN_DIO0, PIN_DIO2);
+static Sx127xSim sx(PIN_SS2, PIN_DIO0_2);
+static uint32_t regTransactions[0x80]; // over all runs, by register
+
+struct SimResult {
+    double decodesPerFrame;
+    double transactionsPerFrame;
+    double bytesPerFrame;
+    double busLoad; // % of air time the SPI bus is busy
+    uint32_t overruns;
+};
+
+static void printResult(const char *name, const SimResult &r) {
+    printf("%-18s %13.2f %12.0f %12.0f %8.1f %9lu\n", name, r.decodesPerFrame, r.transactionsPerFrame,
+        r.bytesPerFrame, r.busLoad, (unsigned long) r.overruns);
+}
+
+/**
+ * @brief bitstream MSB first, built bit by bit
+ */
+class BitWriter {
+public:
+    std::vector<uint8_t> data;
+    uint32_t bits = 0;
+
+    void add(const bool bit) {
+        if ((bits & 7) == 0)
+            data.push_back(0);
+        if (bit)
+            data.back() |= 0x80 >> (bits & 7);
+        bits++;
+    }
+    void add(const bool level, uint16_t n) {
+        while (n-- > 0)
+            add(level);
+    }
+    void addBytes(const uint8_t *buf, const size_t len) {
+        for (size_t i=0; i<len; i++)
+            for (int8_t b=7; b>=0; b--)
+                add((buf[i] >> b) & 1);
+    }
+};
+
+static uint32_t recentHits(RadioApplication &app) {
+    JsonDocument doc;
+    JsonObject obj = doc.to<JsonObject>();
+    app.getStatus(obj);
+    return obj[F("recentFrames")][F("hits")] | 0;
+}
+
+/**
+ * @brief queues a frame FRAMES times on chip and runs the main loop until it is all received
+ * Repeats within REPEATTIMEOUT are suppressed by the RC applications, they count as decodes.
+ */
+template<typename Sim>
+static SimResult runFrames(Sim &chip, RadioApplication &app, const BitWriter &frame, const uint32_t bitrate, const uint32_t gapUs, const int32_t offsetHz = 0) {
+    app.loop();
+    chip.update();
+    const uint32_t publishedStart = mqtt.published;
+    const uint32_t hitsStart = recentHits(app);
+    const uint32_t edgeOverrunsStart = radio->getEdgeOverruns();
+    chip.resetStats();
+
+    const unsigned long start = micros();
+    for (uint32_t i=0; i<FRAMES; i++)
+        chip.queueRx(frame.data.data(), frame.bits, bitrate, -60, gapUs, offsetHz);
+    const unsigned long end = chip.getRxEnd() + TAILUS;
+    while ((long) (micros() - end) < 0) {
+        chip.update();
+        radio->loop();
+        app.loop();
+    }
+
+    const auto &stats = chip.getStats();
+    for (uint8_t i=0; i<0x80; i++)
+        regTransactions[i] += stats.regTransactions[i];
+
+    SimResult r;
+    r.decodesPerFrame = (double) (mqtt.published - publishedStart + recentHits(app) - hitsStart) / FRAMES;
+    r.transactionsPerFrame = (double) stats.spiTransactions / FRAMES;
+    r.bytesPerFrame = (double) stats.spiBytes / FRAMES;
+    r.busLoad = stats.spiBytes * 8.0 / (micros() - start) * 100; // 1 MHz bus clock
+    r.overruns = stats.fifoOverruns + radio->getEdgeOverruns() - edgeOverrunsStart;
+    return r;
+}
+
+static void simRc() {
+    static const struct {
+        const char *name;
+        const uint8_t *pulses;
+        size_t len;
+    } RECORDINGS[] = {
+        {"ittristate", PULSES_ITTRISTATE, sizeof(PULSES_ITTRISTATE)},
+        {"intertechno", PULSES_INTERTECHNO, sizeof(PULSES_INTERTECHNO)},
+        {"EV1527", PULSES_EV1527, sizeof(PULSES_EV1527)},
+        {"emylo", PULSES_EMYLO, sizeof(PULSES_EMYLO)},
+        {"noise", PULSES_NOISE, sizeof(PULSES_NOISE)},
+    };
+
+    for (uint8_t capture=RCCAPTURE_FIFO; capture<=RCCAPTURE_EDGES; capture++) {
+        JsonDocument conf;
+        conf[F("capture")] = capture;
+        Rc433Transceiver *app = new Rc433Transceiver(radio, conf.as<JsonObject>());
+        for (auto &rec : RECORDINGS) {
+            // carrier on / off at the sample rate of FIFO capture
+            BitWriter frame;
+            frame.add(false, RCLEADINGGAP);
+            for (size_t i=0; i<rec.len; i++)
+                frame.add((i % 2) == 0, rec.pulses[i]);
+
+            String name = rec.name;
+            if (capture == RCCAPTURE_EDGES)
+                name += F("/edges");
+            printResult(name.c_str(), runFrames(sim, *app, frame, RCBITRATE, 0));
+        }
+        delete app;
+    }
+}
+
+static BitWriter render868(const uint8_t *sync, const uint8_t syncLen, const uint8_t *payload, const size_t len) {
+    BitWriter frame;
+    for (uint8_t i=0; i<5; i++)
+        frame.addBytes((const uint8_t *) "\xAA", 1); // preamble
+    frame.addBytes(sync, syncLen);
+    frame.addBytes(payload, len);
+    frame.add(false, 8); // trailer
+    return frame;
+}
+
+static void sim868() {
+    static const uint8_t SYNC2DD4[] = {0x2D, 0xD4};
+    static const uint8_t SYNCEC3K[] = {0x13, 0xF1, 0x85, 0xD3, 0xAC};
+    static const struct {
+        const char *name;
+        uint8_t rxMode; // bit of the decoder in rxmodes
+        uint32_t bitrate; // as in Gw868's mode table
+        const uint8_t *sync;
+        uint8_t syncLen;
+        const uint8_t *payload;
+        size_t len;
+    } RECORDINGS[] = {
+        {"LaCrosse", 0, 17241, SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE)},
+        {"EC3K", 3, 20000, SYNCEC3K, sizeof(SYNCEC3K), PAYLOAD_EC3K, sizeof(PAYLOAD_EC3K)},
+        {"Bresser7in1", 4, 8000, SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_BRESSER, sizeof(PAYLOAD_BRESSER)},
+        {"EMT7170", 5, 9579, SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_EMT7170, sizeof(PAYLOAD_EMT7170)},
+    };
+
+    for (auto &rec : RECORDINGS) {
+        JsonDocument conf;
+        conf[F("rxmodes")] = 1 << rec.rxMode;
+        conf[F("interval")] = 1000000; // no mode switching during the run
+        Gw868 *app = new Gw868(radio, conf.as<JsonObject>());
+        app->loop(); // switch to rxMode
+
+        printResult(rec.name, runFrames(sim, *app, render868(rec.sync, rec.syncLen, rec.payload, rec.len), rec.bitrate, GAPUS868));
+        delete app;
+    }
+}
+
+/**
+ * @brief same frames received with all modes demodulated at once from samples
+ * The last row publishes to a slow broker, every MQTT message blocks for SLOWPUBLISHUS. Publishing
+ * is queued behind the FIFO reads, so the FIFO must not overrun.
+ */
+static void simSamples() {
+    static const uint8_t SYNC2DD4[] = {0x2D, 0xD4};
+    static const uint8_t SYNCEC3K[] = {0x13, 0xF1, 0x85, 0xD3, 0xAC};
+    static const struct {
+        const char *name;
+        uint32_t bitrate;
+        const uint8_t *sync;
+        uint8_t syncLen;
+        const uint8_t *payload;
+        size_t len;
+    } RECORDINGS[] = {
+        {"LaCrosse/samples", 17241, SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE)},
+        {"EC3K/samples", 20000, SYNCEC3K, sizeof(SYNCEC3K), PAYLOAD_EC3K, sizeof(PAYLOAD_EC3K)},
+        {"Bresser7in1/samples", 8000, SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_BRESSER, sizeof(PAYLOAD_BRESSER)},
+        {"EMT7170/samples", 9579, SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_EMT7170, sizeof(PAYLOAD_EMT7170)},
+    };
+
+    JsonDocument conf;
+    conf[F("rxmodes")] = 0x3F;
+    conf[F("capture")] = GW868CAPTURE_SAMPLES;
+    Gw868 *app = new Gw868(radio, conf.as<JsonObject>());
+    for (auto &rec : RECORDINGS)
+        printResult(rec.name, runFrames(sim, *app, render868(rec.sync, rec.syncLen, rec.payload, rec.len), rec.bitrate, GAPUS868));
+
+    const uint32_t SLOWPUBLISHUS = 1000;
+    const uint32_t fifoOverrunsStart = radio->getFifoOverruns();
+    mqtt.publishDelayUs = SLOWPUBLISHUS;
+    auto &emt = RECORDINGS[3];
+    printResult("EMT7170/slow mqtt", runFrames(sim, *app, render868(emt.sync, emt.syncLen, emt.payload, emt.len), emt.bitrate, GAPUS868));
+    mqtt.publishDelayUs = 0;
+
+    JsonDocument doc;
+    JsonObject status = doc.to<JsonObject>();
+    app->getStatus(status);
+    printf("%-18s fifo read gap max %lu us, driver overruns %lu, publish drops %lu\n", "", (unsigned long) (status[F("fifoReadGapMax")] | 0),
+        (unsigned long) (radio->getFifoOverruns() - fifoOverrunsStart), (unsigned long) (status[F("publishDrops")] | 0));
+    delete app;
+}
+
+/**
+ * @brief LaCrosse transmitter off by AFCOFFSET, the receiver follows and narrows its filter
+ * The first run is before the offset is known, the second one with the adjusted receiver.
+ */
+static void simAfc() {
+    const int32_t AFCOFFSET = 120000;
+    static const uint8_t SYNC2DD4[] = {0x2D, 0xD4};
+    JsonDocument conf;
+    conf[F("rxmodes")] = 1 << 0;
+    conf[F("interval")] = 1000000;
+    conf[F("afc")] = true;
+    Gw868 *app = new Gw868(radio, conf.as<JsonObject>());
+    app->loop();
+
+    const BitWriter frame = render868(SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE));
+    int32_t carrierOffset = 0;
+    for (uint8_t run=0; run<2; run++) {
+        const SimResult r = runFrames(sim, *app, frame, 17241, GAPUS868, AFCOFFSET - carrierOffset);
+        JsonDocument doc;
+        JsonObject status = doc.to<JsonObject>();
+        app->getStatus(status);
+        carrierOffset = status[F("carrierOffset")] | 0;
+        printResult((run == 0) ? "LaCrosse/afc" : "LaCrosse/afc2", r);
+        printf("%-18s carrier %+ld Hz, channel filter %lu Hz\n", "", (long) carrierOffset,
+            (unsigned long) (status[F("rxBw")] | 0));
+    }
+    delete app;
+}
+
+/**
+ * @brief runs the main loop until done() or timeoutUs passed
+ */
+template<typename Sim, typename Done>
+static void runUntil(Sim &chip, RadioApplication &app, const uint32_t timeoutUs, Done done) {
+    const unsigned long end = micros() + timeoutUs;
+    while ( !done() && ((long) (micros() - end) < 0) ) {
+        chip.update();
+        radio->loop();
+        app.loop();
+    }
+}
+
+/**
+ * @brief a command queued while the FIFO drains behind the last frame of another one is sent
+ * right after it, not only when the next command arrives
+ */
+static void simTxDrain() {
+    const uint32_t TXTIMEOUTUS = 2000000;
+    static const char *const COMMANDS[][2] = {
+        {"intertechno/12345/3/set", "on"},
+        {"intertechno/12345/3/set", "off"},
+    };
+    JsonDocument conf;
+    Rc433Transceiver *app = new Rc433Transceiver(radio, conf.as<JsonObject>());
+
+    // air time of each command alone
+    size_t expected = 0;
+    size_t firstLen = 0;
+    for (auto &cmd : COMMANDS) {
+        sim.clearTxData();
+        app->onMqttMessage(cmd[0], cmd[1]);
+        runUntil(sim, *app, TXTIMEOUTUS, [] { return false; });
+        if (firstLen == 0)
+            firstLen = sim.getTxData().size();
+        expected += sim.getTxData().size();
+    }
+
+    // all chips of the first command are in the FIFO once less than a burst is left to send
+    sim.clearTxData();
+    app->onMqttMessage(COMMANDS[0][0], COMMANDS[0][1]);
+    runUntil(sim, *app, TXTIMEOUTUS, [&] { return sim.getTxData().size() + 8 >= firstLen; });
+    app->onMqttMessage(COMMANDS[1][0], COMMANDS[1][1]);
+    runUntil(sim, *app, TXTIMEOUTUS, [] { return false; });
+
+    const size_t sent = sim.getTxData().size();
+    printf("\n%-18s %12s %12s\n", "tx", "bytes sent", "expected");
+    printf("%-18s %12zu %12zu   %s\n", "queued in drain", sent, expected, (sent == expected) ? "ok" : "FAILED");
+    delete app;
+}
+
+/**
+ * @brief the module loses its registers and hangs in the mode transition after the first frame,
+ * the driver times out, rewrites the registers and requests RX again
+ * Rewriting must not replay commands like clearing the FIFO or FeiStart. The second run checks
+ * that reception is back to normal.
+ */
+static void simModeRecovery() {
+    static const uint8_t SYNC2DD4[] = {0x2D, 0xD4};
+    JsonDocument conf;
+    conf[F("rxmodes")] = 1 << 0;
+    conf[F("interval")] = 1000000;
+    Gw868 *app = new Gw868(radio, conf.as<JsonObject>());
+    app->loop();
+
+    const BitWriter frame = render868(SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE));
+    const uint32_t timeoutsStart = radio->getModeTimeouts();
+    sim.hangSequencer();
+    printResult("LaCrosse/hang", runFrames(sim, *app, frame, 17241, GAPUS868));
+    const uint32_t replayed = sim.getStats().restoreCommands;
+    const SimResult r = runFrames(sim, *app, frame, 17241, GAPUS868);
+    printResult("LaCrosse/recovered", r);
+    const uint32_t timeouts = radio->getModeTimeouts() - timeoutsStart;
+    printf("%-18s mode timeouts %lu, commands replayed %lu   %s\n", "", (unsigned long) timeouts, (unsigned long) replayed,
+        ((timeouts == 1) && (replayed == 0) && (r.decodesPerFrame >= 3.0)) ? "ok" : "FAILED");
+    delete app;
+}
+
+/**
+ * @brief sends one RC command on the current radio, returns the bytes that went on air
+ */
+template<typename Sim>
+static std::vector<uint8_t> sendRcCommand(Sim &chip) {
+    JsonDocument conf;
+    Rc433Transceiver *app = new Rc433Transceiver(radio, conf.as<JsonObject>());
+    chip.clearTxData();
+    app->onMqttMessage("intertechno/12345/3/set", "on");
+    runUntil(chip, *app, 2000000, [] { return false; });
+    delete app;
+    return chip.getTxData();
+}
+
+static String toHex(const uint8_t *buf, const uint8_t len) {
+    String hex;
+    for (uint8_t i=0; i<len; i++) {
+        if (buf[i] < 0x10)
+            hex += '0';
+        hex += String(buf[i], HEX);
+    }
+    return hex;
+}
+
+/**
+ * @brief queues LoRa packets and runs a LoraReceiver until they are over
+ *
+ * @return status of the application
+ */
+static void runLora(LoraReceiver &app, JsonDocument &status) {
+    runUntil(sx, app, sx.getRxEnd() - micros() + TAILUS, [] { return false; });
+    JsonObject obj = status.to<JsonObject>();
+    app.getStatus(obj);
+}
+
+static void printLora(const char *name, JsonDocument &status, const uint32_t packets, const uint32_t crcErrors, const uint32_t missed, const String &last) {
+    const uint32_t p = status[F("packets")] | 0;
+    const uint32_t c = status[F("crcErrors")] | 0;
+    const uint32_t m = sx.getStats().loraMissed;
+    const bool ok = (p == packets) && (c == crcErrors) && (m == missed) && (last == status[F("last")].as<String>());
+    printf("%-18s %8lu %10lu %8lu   %s\n", name, (unsigned long) p, (unsigned long) c, (unsigned long) m, ok ? "ok" : "FAILED");
+}
+
+/**
+ * @brief the Rfm9x driver on the SX127x model at the second chipselect
+ * FSK reception in packet mode and from FIFO samples, OOK reception and transmission of the RC
+ * gateway, the bytes sent have to match the RFM69's. LoRa reception in explicit header mode
+ * with a packet longer than the FSK FIFO, a CRC error and one with another spreading factor,
+ * then in implicit header mode.
+ */
+static void simSx127x() {
+    static const uint8_t SYNC2DD4[] = {0x2D, 0xD4};
+    const std::vector<uint8_t> expected = sendRcCommand(sim);
+
+    SPI.setDevice(&sx);
+    RfmBase *rfm69 = radio;
+    Rfm9x *rfm = new Rfm9x;
+    rfm->begin(PIN_SS2, PIN_DIO0_2);
+    radio = rfm;
+
+    printf("\n%-18s %13s %12s %12s %8s %9s\n", "sx127x", "decodes/frame", "spi/frame", "bytes/frame", "bus %", "overruns");
+    {
+        JsonDocument conf;
+        conf[F("rxmodes")] = 1 << 0;
+        conf[F("interval")] = 1000000;
+        Gw868 *app = new Gw868(radio, conf.as<JsonObject>());
+        app->loop();
+        printResult("LaCrosse/sx", runFrames(sx, *app, render868(SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_LACROSSE, sizeof(PAYLOAD_LACROSSE)), 17241, GAPUS868));
+        delete app;
+
+        conf[F("rxmodes")] = 0x3F;
+        conf[F("capture")] = GW868CAPTURE_SAMPLES;
+        app = new Gw868(radio, conf.as<JsonObject>());
+        printResult("EMT7170/sx samples", runFrames(sx, *app, render868(SYNC2DD4, sizeof(SYNC2DD4), PAYLOAD_EMT7170, sizeof(PAYLOAD_EMT7170)), 9579, GAPUS868));
+        delete app;
+
+        JsonDocument rcConf;
+        Rc433Transceiver *rc = new Rc433Transceiver(radio, rcConf.as<JsonObject>());
+        BitWriter frame;
+        frame.add(false, RCLEADINGGAP);
+        for (size_t i=0; i<sizeof(PULSES_INTERTECHNO); i++)
+            frame.add((i % 2) == 0, PULSES_INTERTECHNO[i]);
+        printResult("intertechno/sx", runFrames(sx, *rc, frame, RCBITRATE, 0));
+        delete rc;
+    }
+
+    const std::vector<uint8_t> sent = sendRcCommand(sx);
+    printf("%-18s %12s %12s\n", "", "bytes sent", "as RFM69");
+    printf("%-18s %12zu %12s   %s\n", "tx intertechno", sent.size(), (sent == expected) ? "same" : "differ",
+        (!sent.empty() && (sent == expected)) ? "ok" : "FAILED");
+
+    RfmBase::LoraConfig cfg = {9, 125000, 5, 0x12, 0, true};
+    Sx127xSim::LoraTx tx = {cfg.spreadingFactor, cfg.bandwidth, cfg.codingRate, cfg.syncWord, false, true, -90, 6};
+    uint8_t payload[200];
+    for (size_t i=0; i<sizeof(payload); i++)
+        payload[i] = i * 7;
+
+    printf("\n%-18s %8s %10s %8s\n", "lora", "packets", "crc errors", "missed");
+    {
+        JsonDocument conf;
+        conf[F("sf")] = cfg.spreadingFactor;
+        conf[F("bw")] = cfg.bandwidth;
+        LoraReceiver *app = new LoraReceiver(radio, conf.as<JsonObject>());
+        runUntil(sx, *app, 1000, [] { return false; }); // RXCONTINUOUS ready
+        sx.resetStats();
+        sx.queueLora(payload, 20, tx, 5000);
+        sx.queueLora(payload, 20, tx, 5000, false);
+        Sx127xSim::LoraTx sf10 = tx;
+        sf10.spreadingFactor = 10;
+        sx.queueLora(payload, 20, sf10, 5000);
+        sx.queueLora(payload, sizeof(payload), tx, 5000);
+        JsonDocument status;
+        runLora(*app, status);
+        printLora("explicit", status, 2, 1, 1, toHex(payload, sizeof(payload)));
+        delete app;
+
+        const uint8_t IMPLICITLEN = 12;
+        conf[F("implicitlen")] = IMPLICITLEN;
+        app = new LoraReceiver(radio, conf.as<JsonObject>());
+        runUntil(sx, *app, 1000, [] { return false; });
+        sx.resetStats();
+        const uint32_t crcErrorsStart = radio->getCrcErrors();
+        sx.queueLora(payload, 20, tx, 5000); // explicit header, not received
+        tx.implicit = true;
+        sx.queueLora(payload + 1, IMPLICITLEN, tx, 5000);
+        runLora(*app, status);
+        status[F("crcErrors")] = (status[F("crcErrors")] | 0) - crcErrorsStart;
+        printLora("implicit", status, 1, 0, 1, toHex(payload + 1, IMPLICITLEN));
+        delete app;
+    }
+
+    radio = rfm69;
+    delete rfm;
+    SPI.setDevice(&sim);
+}
+
+/**
+ * @brief registers by SPI transactions over all runs
+ */
+static void printRegisters() {
+    std::vector<uint8_t> regs;
+    for (uint8_t i=0; i<0x80; i++)
+        if (regTransactions[i] > 0)
+            regs.push_back(i);
+    std::sort(regs.begin(), regs.end(), [](uint8_t a, uint8_t b) { return regTransactions[a] > regTransactions[b]; });
+    if (regs.size() > 8)
+        regs.resize(8);
+
+    printf("\n%-8s %12s\n", "register", "transactions");
+    for (uint8_t reg : regs)
+        printf("0x%02X     %12lu\n", reg, (unsigned long) regTransactions[reg]);
+}
+
+int main() {
+    SPI.setDevice(&sim);
+    Rfm69 *rfm = new Rfm69;
+    rfm->begin(PIN_SS, false, PIN_DIO0, PIN_DIO2);
+    radio = rfm;
+
+    printf("%-18s %13s %12s %12s %8s %9s\n", "recording", "decodes/frame", "spi/frame", "bytes/frame", "bus %", "overruns");
+    simRc();
+    sim868();
+    simSamples();
+    simAfc();
+    simModeRecovery();
+    simTxDrain();
+    printRegisters();
+    simSx127x();
+    return 0;
+}
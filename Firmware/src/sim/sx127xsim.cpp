@@ -0,0 +1,684 @@
+#include "sx127xsim.h"
+
+static const int8_t NOISERSSI = -110; // dBm without signal
+static const double FSTEP = 32E6 / (1UL<<19);
+static const uint32_t LORABANDWIDTHS[] = {7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000};
+
+Sx127xSim::Sx127xSim(const uint8_t pinSS, const uint8_t pinDio0):
+        pinSS(pinSS),
+        pinDio0(pinDio0),
+        addrPhase(true),
+        writeAccess(false),
+        addr(0),
+        fifoHead(0),
+        fifoLen(0),
+        fifoOverrun(false),
+        loraIrq(0),
+        mode(MODE_STDBY),
+        readyNs(NEVER),
+        rxSinceNs(NEVER),
+        simNs((uint64_t) micros() * 1000),
+        advancing(false),
+        rxState(RX_OFF),
+        rxNextNs(NEVER),
+        syncShift(0),
+        syncBits(0),
+        rxByte(0),
+        rxBits(0),
+        rxRemaining(0),
+        syncMatch(false),
+        payloadReady(false),
+        txStarted(false),
+        txStarved(false),
+        txLength(false),
+        txLast(false),
+        txRemaining(0),
+        txNextNs(NEVER),
+        packetSent(false),
+        noise(0xACE1),
+        dio0Level(LOW) {
+    memset(regs, 0, sizeof(regs));
+    regs[0x01] = 1<<3 | MODE_STDBY; // FSK, LowFrequencyModeOn
+    regs[0x02] = 0x1A; // 4.8 kbit/s
+    regs[0x03] = 0x0B;
+    regs[0x05] = 0x52;
+    regs[0x06] = 0x6C; // 434 MHz
+    regs[0x07] = 0x80;
+    regs[0x09] = 0x4F;
+    regs[0x12] = 0x15;
+    regs[0x26] = 0x03;
+    regs[0x27] = 0x93;
+    for (uint8_t i=0; i<8; i++)
+        regs[0x28 + i] = 0x01;
+    regs[0x30] = 0x90;
+    regs[0x31] = 0x40;
+    regs[0x32] = 0x40;
+    regs[0x35] = 0x0F;
+    regs[0x42] = 0x12; // RegVersion
+
+    memset(loraRegs, 0, sizeof(loraRegs));
+    loraRegs[0x0E] = 0x80; // FifoTxBaseAddr
+    loraRegs[0x1D] = 0x72; // 125 kHz, 4/5, explicit header
+    loraRegs[0x1E] = 0x70; // SF7
+    loraRegs[0x21] = 0x08;
+    loraRegs[0x22] = 0x01;
+    loraRegs[0x23] = 0xFF;
+    loraRegs[0x26] = 0x04;
+    loraRegs[0x31] = 0xC3;
+    loraRegs[0x37] = 0x0A;
+    loraRegs[0x39] = 0x12;
+    memset(loraFifo, 0, sizeof(loraFifo));
+
+    resetStats();
+    mockPinHook(pinSS, csHook, this);
+    mockTimeHook(timeHook, this);
+}
+
+Sx127xSim::~Sx127xSim() {
+    mockPinHook(pinSS, nullptr, nullptr);
+    mockTimeHook(nullptr, this);
+}
+
+void Sx127xSim::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief queues FSK / OOK input, see Rfm69Sim::queueRx()
+ */
+void Sx127xSim::queueRx(const uint8_t *data, const uint32_t bits, const uint32_t bitrate, const int8_t rssi, const uint32_t gapUs, const int32_t offsetHz) {
+    Segment s;
+    s.startNs = (uint64_t) micros() * 1000;
+    if (!rf.empty() && (rf.back().endNs() > s.startNs))
+        s.startNs = rf.back().endNs();
+    s.startNs += (uint64_t) gapUs * 1000;
+    s.bitNs = 1000000000ULL / bitrate;
+    s.data.assign(data, data + (bits + 7) / 8);
+    s.bits = bits;
+    s.rssi = rssi;
+    s.freqHz = frf() + offsetHz;
+    rf.push_back(s);
+}
+
+/**
+ * @brief queues a LoRa packet on the current carrier, it starts after the previously queued one
+ * or now. The time on air follows the formula of the datasheet with 8 preamble symbols.
+ *
+ * @param crcOk false: the payload CRC doesn't match
+ */
+void Sx127xSim::queueLora(const uint8_t *data, const uint8_t len, const LoraTx &tx, const uint32_t gapUs, const bool crcOk) {
+    const uint64_t symbolNs = (1000000000ULL << tx.spreadingFactor) / tx.bandwidth;
+    const int de = (symbolNs > 16000000ULL) ? 1 : 0; // LowDataRateOptimize
+    const int num = 8 * len - 4 * tx.spreadingFactor + 28 + 16 * tx.crc - 20 * tx.implicit;
+    const int den = 4 * (tx.spreadingFactor - 2 * de);
+    const int payloadSymbols = 8 + ((num > 0) ? (num + den - 1) / den * tx.codingRate : 0);
+
+    LoraPacket p;
+    p.startNs = (uint64_t) micros() * 1000;
+    if (!loraRf.empty() && (loraRf.back().endNs > p.startNs))
+        p.startNs = loraRf.back().endNs;
+    p.startNs += (uint64_t) gapUs * 1000;
+    p.endNs = p.startNs + (12 + payloadSymbols) * symbolNs + symbolNs / 4; // 8 + 4.25 symbols preamble
+    p.data.assign(data, data + len);
+    p.tx = tx;
+    p.crcOk = crcOk;
+    p.freqHz = frf();
+    loraRf.push_back(p);
+}
+
+/**
+ * @return micros() at the end of the queued RF input
+ */
+unsigned long Sx127xSim::getRxEnd() const {
+    uint64_t end = (uint64_t) micros() * 1000;
+    if (!rf.empty())
+        end = std::max(end, rf.back().endNs());
+    if (!loraRf.empty())
+        end = std::max(end, loraRf.back().endNs);
+    return end / 1000;
+}
+
+/**
+ * @brief processes everything up to now, call while the driver does not access the chip
+ */
+void Sx127xSim::update() {
+    advance((uint64_t) micros() * 1000);
+    updateDio();
+}
+
+void Sx127xSim::csHook(void *arg, uint8_t val) {
+    Sx127xSim *sim = static_cast<Sx127xSim*>(arg);
+    sim->advance((uint64_t) micros() * 1000);
+    if (val == LOW) {
+        sim->addrPhase = true;
+        sim->stats.spiTransactions++;
+    }
+    else
+        sim->updateDio();
+}
+
+void Sx127xSim::timeHook(void *arg) {
+    Sx127xSim *sim = static_cast<Sx127xSim*>(arg);
+    sim->advance((uint64_t) micros() * 1000);
+}
+
+uint8_t Sx127xSim::transfer(uint8_t data) {
+    stats.spiBytes++;
+    if (addrPhase) {
+        addrPhase = false;
+        addr = data & 0x7F;
+        writeAccess = (data & 0x80) != 0;
+        stats.regTransactions[addr]++;
+        return 0;
+    }
+
+    const bool loraPage = isLora() && (addr >= 0x0D) && (addr <= 0x3F);
+    uint8_t result = 0;
+    if (writeAccess) {
+        if (loraPage)
+            writeLoraRegister(addr, data);
+        else
+            writeRegister(addr, data);
+    }
+    else
+        result = loraPage ? readLoraRegister(addr) : readRegister(addr);
+    if (addr != 0) // FIFO is accessed repeatedly in bursts
+        addr = (addr + 1) & 0x7F;
+    return result;
+}
+
+uint64_t Sx127xSim::bitNs() const {
+    const uint16_t br = regs[0x02] << 8 | regs[0x03];
+    return (br > 0) ? br * 1000ULL / 32 : 1; // FXOSC 32 MHz
+}
+
+/**
+ * @brief carrier frequency in Hz, RegFrf is shared by both modems
+ */
+double Sx127xSim::frf() const {
+    return (regs[0x06] << 16 | regs[0x07] << 8 | regs[0x08]) * FSTEP;
+}
+
+/**
+ * @brief single side bandwidth of the FSK / OOK channel filter in Hz
+ */
+uint32_t Sx127xSim::rxBw() const {
+    const uint8_t mant = 16 + 4 * ((regs[0x12] >> 3) & 3);
+    const uint8_t exp = regs[0x12] & 7;
+    return 32000000UL / ((uint32_t) mant << (exp + (isOok() ? 3 : 2)));
+}
+
+/**
+ * @brief processes receivers, transmitter and mode transitions in time order up to untilNs
+ * LoRa packets are handled at their end in either modem, they are dropped in FSK / OOK mode.
+ */
+void Sx127xSim::advance(const uint64_t untilNs) {
+    if (advancing) // chip accessed from an interrupt handler
+        return;
+    advancing = true;
+
+    while (true) {
+        uint64_t t = NEVER;
+        if (!isReady())
+            t = readyNs;
+        else if ( (mode == MODE_RX) && !isLora() && !isContinuous() )
+            t = rxNextNs;
+        else if ( (mode == MODE_TX) && txStarted )
+            t = txNextNs;
+        const bool lora = !loraRf.empty() && (loraRf.front().endNs < t);
+        if (lora)
+            t = loraRf.front().endNs;
+        if (t > untilNs)
+            break;
+
+        simNs = t;
+        if (lora)
+            loraRx();
+        else if (!isReady())
+            onModeReady();
+        else if (mode == MODE_RX) {
+            const int level = rfLevel(t);
+            rxBit((level < 0) ? (!isOok() && noiseBit()) : (level > 0));
+            rxNextNs += bitNs();
+        }
+        else
+            txSlot();
+        updateDio();
+    }
+
+    if (untilNs > simNs)
+        simNs = untilNs;
+    advancing = false;
+}
+
+/**
+ * @brief FSK / OOK input at time t, see Rfm69Sim::rfLevel()
+ */
+int Sx127xSim::rfLevel(const uint64_t t, int8_t *rssi) {
+    while (!rf.empty() && (rf.front().endNs() <= t))
+        rf.pop_front();
+
+    if (rssi != nullptr)
+        *rssi = NOISERSSI;
+    if (rf.empty() || (t < rf.front().startNs))
+        return -1;
+
+    const Segment &s = rf.front();
+    if (fabs(s.freqHz - frf()) > rxBw()) // outside the channel filter
+        return -1;
+
+    const uint32_t i = (t - s.startNs) / s.bitNs;
+    const int bit = (s.data[i >> 3] >> (7 - (i & 7))) & 1;
+    if ( (rssi != nullptr) && ((bit != 0) || !isOok()) )
+        *rssi = s.rssi;
+    return bit;
+}
+
+bool Sx127xSim::noiseBit() {
+    noise = (noise >> 1) ^ (-(noise & 1) & 0xB400);
+    return (noise & 1) != 0;
+}
+
+/**
+ * @brief starts a transition, FSTX / FSRX take the time of the RFM69's FS mode
+ */
+void Sx127xSim::setMode(const Mode newMode) {
+    if (newMode == mode)
+        return;
+
+    if (mode == MODE_RX) {
+        rxState = RX_OFF;
+        syncMatch = false;
+        payloadReady = false;
+        rxSinceNs = NEVER;
+    }
+    else if (mode == MODE_TX) {
+        txStarted = false;
+        packetSent = false;
+    }
+
+    uint32_t us = 0;
+    switch (newMode) {
+    case MODE_SLEEP:
+        us = 10;
+        break;
+    case MODE_STDBY:
+        us = (mode == MODE_SLEEP) ? 250 : 10;
+        break;
+    case MODE_FSTX:
+    case MODE_FSRX:
+        us = (mode == MODE_SLEEP) ? 310 : 60;
+        break;
+    case MODE_TX:
+        us = ((mode < MODE_FSTX) ? 60 : 0) + 50;
+        break;
+    case MODE_RX:
+        us = ((mode < MODE_FSTX) ? 60 : 0) + 100;
+        break;
+    }
+    mode = newMode;
+    readyNs = simNs + us * 1000ULL;
+}
+
+void Sx127xSim::onModeReady() {
+    readyNs = NEVER;
+    if (mode == MODE_RX) {
+        rxSinceNs = simNs;
+        if (isLora())
+            loraRegs[0x25] = loraRegs[0x0F]; // FifoRxByteAddr starts at FifoRxBaseAddr
+        else
+            startRx();
+    }
+    else if ( (mode == MODE_TX) && !isLora() ) {
+        txStarved = false;
+        txLast = false;
+        packetSent = false;
+        txLength = (regs[0x30] & (1<<7)) != 0;
+        txRemaining = txLength ? 0 : regs[0x32];
+        checkTxStart();
+    }
+}
+
+void Sx127xSim::startRx() {
+    clearFifo();
+    if (isContinuous()) {
+        rxState = RX_OFF;
+        return;
+    }
+
+    rxNextNs = simNs + bitNs() / 2;
+    restartRx();
+}
+
+void Sx127xSim::restartRx() {
+    syncMatch = false;
+    payloadReady = false;
+    syncShift = 0;
+    syncBits = 0;
+    if ((regs[0x27] & (1<<4)) == 0) // SyncOn off, the FIFO is filled from the start
+        startPayload();
+    else
+        rxState = RX_SYNC;
+}
+
+void Sx127xSim::startPayload() {
+    rxBits = 0;
+    if ((regs[0x30] & (1<<7)) != 0) // variable length
+        rxState = RX_LENGTH;
+    else {
+        rxState = RX_PAYLOAD;
+        rxRemaining = regs[0x32];
+    }
+}
+
+void Sx127xSim::rxBit(const bool bit) {
+    switch (rxState) {
+    case RX_SYNC: {
+        syncShift = syncShift << 1 | bit;
+        if (syncBits < 64)
+            syncBits++;
+        const uint8_t len = (regs[0x27] & 7) + 1;
+        if (syncBits < len * 8)
+            break;
+
+        uint64_t word = 0;
+        for (uint8_t i=0; i<len; i++)
+            word = word << 8 | regs[0x28 + i];
+        const uint64_t mask = (len == 8) ? ~0ULL : (1ULL << (len * 8)) - 1;
+        if ((syncShift & mask) == word) {
+            syncMatch = true;
+            stats.syncMatches++;
+            if (rfLevel(simNs) >= 0) { // FEI is latched with the sync match
+                const int16_t fei = lround((rf.front().freqHz - frf()) / FSTEP);
+                regs[0x1D] = fei >> 8;
+                regs[0x1E] = fei;
+            }
+            startPayload();
+        }
+        break;
+    }
+
+    case RX_LENGTH:
+    case RX_PAYLOAD:
+        rxByte = rxByte << 1 | bit;
+        if (++rxBits < 8)
+            break;
+        rxBits = 0;
+        pushFifo(rxByte);
+
+        if (rxState == RX_LENGTH) {
+            rxState = RX_PAYLOAD;
+            rxRemaining = rxByte;
+            if (rxRemaining > 0)
+                break;
+        }
+        else if ( (rxRemaining == 0) || (--rxRemaining > 0) ) // unlimited or more bytes to come
+            break;
+
+        rxState = RX_DONE;
+        payloadReady = true;
+        stats.payloadsReady++;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief end of the first queued LoRa packet, stored in the FIFO at FifoRxByteAddr if the
+ * receiver could demodulate it
+ */
+void Sx127xSim::loraRx() {
+    const LoraPacket p = loraRf.front();
+    loraRf.pop_front();
+
+    const bool implicit = (loraRegs[0x1D] & 1) != 0;
+    if ( !isLora() || (mode != MODE_RX) || (rxSinceNs > p.startNs)
+            || (p.tx.spreadingFactor != loraRegs[0x1E] >> 4)
+            || (p.tx.bandwidth != LORABANDWIDTHS[std::min(loraRegs[0x1D] >> 4, 9)])
+            || (p.tx.syncWord != loraRegs[0x39])
+            || (fabs(p.freqHz - frf()) > p.tx.bandwidth / 2)
+            || (p.tx.implicit != implicit)
+            || (implicit && (p.data.size() != loraRegs[0x22])) ) {
+        stats.loraMissed++;
+        return;
+    }
+
+    const uint8_t start = loraRegs[0x25];
+    for (uint8_t b : p.data)
+        loraFifo[loraRegs[0x25]++] = b;
+    loraRegs[0x10] = start; // FifoRxCurrentAddr
+    loraRegs[0x13] = p.data.size(); // RxNbBytes
+    loraRegs[0x19] = p.tx.snr * 4; // PktSnrValue
+    loraRegs[0x1A] = p.tx.rssi - ((p.tx.snr < 0) ? p.tx.snr : 0) + (((regs[0x01] & (1<<3)) != 0) ? 164 : 157);
+
+    loraIrq |= 1<<6; // RxDone
+    if (!implicit)
+        loraIrq |= 1<<4; // ValidHeader
+    const bool crcChecked = implicit ? (loraRegs[0x1E] & (1<<2)) != 0 : p.tx.crc;
+    if (crcChecked && !p.crcOk) {
+        loraIrq |= 1<<5; // PayloadCrcError
+        stats.crcErrors++;
+    }
+    stats.payloadsReady++;
+}
+
+/**
+ * @brief TxStartCondition: FIFO not empty or FifoLevel above threshold
+ */
+void Sx127xSim::checkTxStart() {
+    if ( (mode != MODE_TX) || !isReady() || txStarted || packetSent || isLora() )
+        return;
+
+    const bool notEmpty = (regs[0x35] & (1<<7)) != 0;
+    if ( notEmpty ? (fifoLen > 0) : (fifoLen > (regs[0x35] & 0x3F)) ) {
+        txStarted = true;
+        txNextNs = simNs;
+    }
+}
+
+/**
+ * @brief next byte moves from the FIFO to the modulator
+ */
+void Sx127xSim::txSlot() {
+    txNextNs += 8 * bitNs();
+    if (txLast) {
+        txStarted = false;
+        packetSent = true;
+        stats.packetsSent++;
+        return;
+    }
+
+    if (fifoLen == 0) {
+        txStarved = true;
+        return;
+    }
+
+    const uint8_t data = popFifo();
+    txData.push_back(data);
+    if (txLength) {
+        txLength = false;
+        txRemaining = data;
+        txLast = (data == 0);
+    }
+    else if (txRemaining > 0)
+        txLast = (--txRemaining == 0);
+}
+
+void Sx127xSim::pushFifo(const uint8_t data) {
+    if (fifoLen == FIFOSIZE) {
+        fifoOverrun = true;
+        stats.fifoOverruns++;
+        return;
+    }
+    fifo[(fifoHead + fifoLen) % FIFOSIZE] = data;
+    fifoLen++;
+}
+
+uint8_t Sx127xSim::popFifo() {
+    if (fifoLen == 0)
+        return 0;
+
+    const uint8_t data = fifo[fifoHead];
+    fifoHead = (fifoHead + 1) % FIFOSIZE;
+    fifoLen--;
+    if ( (fifoLen == 0) && (rxState == RX_DONE) ) {
+        if ((regs[0x27] & (3<<6)) != 0) // AutoRestartRxMode
+            restartRx();
+        else {
+            syncMatch = false;
+            payloadReady = false;
+        }
+    }
+    return data;
+}
+
+void Sx127xSim::clearFifo() {
+    fifoHead = 0;
+    fifoLen = 0;
+    fifoOverrun = false;
+}
+
+uint8_t Sx127xSim::readRegister(const uint8_t reg) {
+    switch (reg) {
+    case 0x00: // RegFifo
+        if (isLora())
+            return loraFifo[loraRegs[0x0D]++];
+        return popFifo();
+
+    case 0x01: // RegOpMode, mode bits as requested
+        return regs[reg];
+
+    case 0x11: { // RegRssiValue
+        int8_t rssi;
+        rfLevel(simNs, &rssi);
+        return -2 * rssi;
+    }
+
+    case 0x3E: { // RegIrqFlags1
+        uint8_t flags = 0;
+        if (isReady()) {
+            flags |= 1<<7; // ModeReady
+            if (mode == MODE_RX)
+                flags |= 1<<6;
+            if (mode == MODE_TX)
+                flags |= 1<<5;
+            if ( (mode != MODE_SLEEP) && (mode != MODE_STDBY) )
+                flags |= 1<<4; // PllLock
+        }
+        if (syncMatch)
+            flags |= 1<<0;
+        return flags;
+    }
+
+    case 0x3F: { // RegIrqFlags2
+        uint8_t flags = 0;
+        if (fifoLen == FIFOSIZE)
+            flags |= 1<<7;
+        if (fifoLen == 0)
+            flags |= 1<<6; // FifoEmpty
+        if (fifoLen > (regs[0x35] & 0x3F))
+            flags |= 1<<5;
+        if (fifoOverrun)
+            flags |= 1<<4;
+        if (packetSent)
+            flags |= 1<<3;
+        if (payloadReady)
+            flags |= 1<<2;
+        return flags;
+    }
+
+    default:
+        return regs[reg];
+    }
+}
+
+void Sx127xSim::writeRegister(const uint8_t reg, const uint8_t value) {
+    switch (reg) {
+    case 0x00: // RegFifo
+        if (isLora()) {
+            loraFifo[loraRegs[0x0D]++] = value;
+            break;
+        }
+        pushFifo(value);
+        if (txStarted && txStarved) {
+            stats.txUnderruns++;
+            txStarved = false;
+        }
+        checkTxStart();
+        break;
+
+    case 0x01: { // RegOpMode, LongRangeMode can be changed in sleep mode only
+        uint8_t v = value;
+        if (mode != MODE_SLEEP)
+            v = (v & ~(1<<7)) | (regs[reg] & (1<<7));
+        regs[reg] = v;
+        const uint8_t m = v & 7;
+        setMode((m <= MODE_RX) ? (Mode) m : MODE_STDBY);
+        break;
+    }
+
+    case 0x3F: // RegIrqFlags2, writing FifoOverrun clears the FIFO
+        if ((value & (1<<4)) != 0)
+            clearFifo();
+        break;
+
+    case 0x11: // read only
+    case 0x1D:
+    case 0x1E:
+    case 0x3E:
+    case 0x42:
+        break;
+
+    default:
+        regs[reg] = value;
+        break;
+    }
+}
+
+uint8_t Sx127xSim::readLoraRegister(const uint8_t reg) {
+    if (reg == 0x12) // RegIrqFlags
+        return loraIrq;
+    return loraRegs[reg];
+}
+
+void Sx127xSim::writeLoraRegister(const uint8_t reg, const uint8_t value) {
+    switch (reg) {
+    case 0x12: // RegIrqFlags, set bits are cleared
+        loraIrq &= ~value;
+        break;
+
+    case 0x10: // read only
+    case 0x13:
+    case 0x19:
+    case 0x1A:
+    case 0x25:
+        break;
+
+    default:
+        loraRegs[reg] = value;
+        break;
+    }
+}
+
+/**
+ * @brief DIO0 mapping 00: PayloadReady in RX, PacketSent in TX, RxDone in LoRa mode
+ */
+void Sx127xSim::updateDio() {
+    const uint8_t mapping = regs[0x40] >> 6;
+    uint8_t level = LOW;
+    if (mapping == 0) {
+        if (isLora())
+            level = (loraIrq & (1<<6)) != 0;
+        else if (mode == MODE_RX)
+            level = payloadReady;
+        else if (mode == MODE_TX)
+            level = packetSent;
+    }
+
+    if (level != dio0Level) {
+        dio0Level = level;
+        mockPinInput(pinDio0, level, simNs / 1000);
+    }
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <Arduino.h>
+#include <SPI.h>
+#include <deque>
+#include <vector>
+
+/**
+ * @brief register-level model of an SX1276 based RFM95 / RFM96 / RFM97 / RFM98 on the mock SPI
+ * bus and GPIOs, for host runs of the Rfm9x driver and the applications
+ *
+ * FSK / OOK modem: register file, mode transitions with ModeReady delay, the 64 byte FIFO with
+ * the SX127x flags (FifoEmpty instead of FifoNotEmpty), the packet engine for fixed, variable and
+ * unlimited length with sync word detection, FEI latched at sync match and DIO0 mapping 00.
+ * LoRa modem: packets queued with queueLora() are received as a whole at their end, if the
+ * receiver was in RXCONTINUOUS before their start and spreading factor, bandwidth, sync word and
+ * header mode match. They are stored one after the other in the 256 byte FIFO, with RxNbBytes,
+ * FifoRxCurrentAddr, RxDone / PayloadCrcError / ValidHeader and RxDone on DIO0.
+ * Not modelled: continuous mode, CRC in FSK, RSSI threshold, timeouts, LoRa TX and CAD.
+ *
+ * Timing works like Rfm69Sim: the state is advanced to micros() on every chipselect, by update()
+ * and by the mock's time hook.
+ */
+class Sx127xSim: public SPIDevice {
+public:
+    static const uint8_t FIFOSIZE = 64;
+
+    struct Stats {
+        uint32_t spiTransactions;
+        uint32_t spiBytes;
+        uint32_t regTransactions[0x80]; // by start address of the transaction
+        uint32_t fifoOverruns; // received bytes lost, FIFO was full
+        uint32_t txUnderruns; // FIFO ran empty during TX and was refilled afterwards
+        uint32_t syncMatches;
+        uint32_t payloadsReady; // FSK PayloadReady and LoRa RxDone
+        uint32_t packetsSent;
+        uint32_t loraMissed; // LoRa packets not received, receiver not ready or settings don't match
+        uint32_t crcErrors; // LoRa packets received with PayloadCrcError
+    };
+
+    /**
+     * @brief LoRa transmission
+     */
+    struct LoraTx {
+        uint8_t spreadingFactor;
+        uint32_t bandwidth; // Hz
+        uint8_t codingRate; // 5..8 for 4/5..4/8
+        uint8_t syncWord;
+        bool implicit; // no header, the receiver has to know length and CRC
+        bool crc;
+        int8_t rssi; // packet RSSI as reported by the chip
+        int8_t snr; // dB
+    };
+
+    Sx127xSim(const uint8_t pinSS, const uint8_t pinDio0);
+    ~Sx127xSim();
+
+    void queueRx(const uint8_t *data, const uint32_t bits, const uint32_t bitrate, const int8_t rssi = -60, const uint32_t gapUs = 0, const int32_t offsetHz = 0);
+    void queueLora(const uint8_t *data, const uint8_t len, const LoraTx &tx, const uint32_t gapUs = 0, const bool crcOk = true);
+    unsigned long getRxEnd() const;
+    void update();
+
+    const Stats &getStats() const { return stats; }
+    void resetStats();
+    const std::vector<uint8_t> &getTxData() const { return txData; }
+    void clearTxData() { txData.clear(); }
+
+    uint8_t transfer(uint8_t data);
+
+private:
+    enum Mode: uint8_t {
+        MODE_SLEEP = 0,
+        MODE_STDBY = 1,
+        MODE_FSTX = 2,
+        MODE_TX = 3,
+        MODE_FSRX = 4,
+        MODE_RX = 5 // RXCONTINUOUS in LoRa mode
+    };
+
+    enum RxState: uint8_t {
+        RX_OFF,
+        RX_SYNC, // waiting for sync word
+        RX_LENGTH, // variable length, next byte is the length
+        RX_PAYLOAD,
+        RX_DONE // PayloadReady, waiting for the FIFO to be emptied
+    };
+
+    struct Segment {
+        uint64_t startNs;
+        uint64_t bitNs;
+        std::vector<uint8_t> data; // MSB first
+        uint32_t bits;
+        int8_t rssi;
+        double freqHz; // carrier of the transmitter
+        uint64_t endNs() const { return startNs + bits * bitNs; }
+    };
+
+    struct LoraPacket {
+        uint64_t startNs;
+        uint64_t endNs;
+        std::vector<uint8_t> data;
+        LoraTx tx;
+        bool crcOk;
+        double freqHz;
+    };
+
+    static const uint64_t NEVER = ~0ULL;
+
+    uint8_t pinSS;
+    uint8_t pinDio0;
+    uint8_t regs[0x80]; // common registers and the FSK / OOK page 0x0D - 0x3F
+    uint8_t loraRegs[0x40]; // LoRa page 0x0D - 0x3F
+
+    bool addrPhase; // next byte on the bus is an address
+    bool writeAccess;
+    uint8_t addr;
+
+    uint8_t fifo[FIFOSIZE];
+    uint8_t fifoHead;
+    uint8_t fifoLen;
+    bool fifoOverrun;
+    uint8_t loraFifo[256];
+    uint8_t loraIrq; // RegIrqFlags of the LoRa modem
+
+    Mode mode;
+    uint64_t readyNs; // time of ModeReady, NEVER if ready
+    uint64_t rxSinceNs; // RX got ready
+    uint64_t simNs; // state is advanced up to here
+    bool advancing;
+
+    RxState rxState;
+    uint64_t rxNextNs; // next sampling point
+    uint64_t syncShift;
+    uint8_t syncBits;
+    uint8_t rxByte;
+    uint8_t rxBits;
+    uint16_t rxRemaining; // bytes until PayloadReady, 0: unlimited
+    bool syncMatch;
+    bool payloadReady;
+
+    bool txStarted;
+    bool txStarved; // FIFO was empty at the last byte slot
+    bool txLength; // variable length, next byte is the length
+    bool txLast; // last byte of the packet is being sent
+    uint16_t txRemaining; // bytes until PacketSent, 0: unlimited
+    uint64_t txNextNs;
+    bool packetSent;
+
+    std::deque<Segment> rf;
+    std::deque<LoraPacket> loraRf;
+    uint32_t noise; // LFSR, FSK receiver output without signal
+    uint8_t dio0Level;
+    Stats stats;
+    std::vector<uint8_t> txData;
+
+    static void csHook(void *arg, uint8_t val);
+    static void timeHook(void *arg);
+    bool isReady() const { return readyNs == NEVER; }
+    bool isLora() const { return (regs[0x01] & (1<<7)) != 0; }
+    bool isContinuous() const { return (regs[0x31] & (1<<6)) == 0; }
+    bool isOok() const { return ((regs[0x01] >> 5) & 3) == 1; }
+    uint64_t bitNs() const;
+    uint32_t rxBw() const;
+    double frf() const;
+    void advance(const uint64_t untilNs);
+    int rfLevel(const uint64_t t, int8_t *rssi = nullptr);
+    bool noiseBit();
+    void setMode(const Mode newMode);
+    void onModeReady();
+    void startRx();
+    void restartRx();
+    void startPayload();
+    void rxBit(const bool bit);
+    void loraRx();
+    void checkTxStart();
+    void txSlot();
+    void pushFifo(const uint8_t data);
+    uint8_t popFifo();
+    void clearFifo();
+    uint8_t readRegister(const uint8_t reg);
+    void writeRegister(const uint8_t reg, const uint8_t value);
+    uint8_t readLoraRegister(const uint8_t reg);
+    void writeLoraRegister(const uint8_t reg, const uint8_t value);
+    void updateDio();
+};